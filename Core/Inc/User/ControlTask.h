@@ -11,6 +11,7 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "User/InputTask.h"
+#include "User/sequence.h"
 
 void ControlTask_Init(void);
 
@@ -21,7 +22,68 @@ typedef enum {
 	MODE_BLOCKED
 } CraneMode;
 
+// from another task the mode, gains and step controller setters are requests, ControlTask
+// applies them at the start of its next pass
 void ControlTask_SetMode(CraneMode mode);
 
+// how a height step's last move went
+typedef struct {
+    uint32_t settleMs;     // step start to done
+    int32_t overshootUm;   // furthest past the target
+    uint32_t runs;         // moves measured since boot
+} VertStepStats;
+
+// what the sequence engine measures itself
+typedef struct {
+    uint32_t stepMs[SEQ_MAX_STEPS];   // last run of each step, start to done
+    uint8_t steps;                    // steps in the last complete run
+    uint32_t totalMs;                 // last complete run, auto selected to last step done
+    uint32_t serialMs;                // its step times added up, what it takes without overlap
+    uint32_t transitionLastCyc;       // one step done to the next one's first command, cpu cycles
+    uint32_t transitionMaxCyc;
+    uint32_t runs;                    // complete runs since boot
+    uint32_t aborts;                  // runs stopped by a step timeout
+} SeqStats;
+
+// controller for a height step of the active table
+void ControlTask_SetStepController(uint8_t step, VertCtrl ctrl);
+// gains x1000, see pid.h. resets the integral
+void ControlTask_SetVerticalGains(int32_t kp, int32_t ki, int32_t kd);
+void ControlTask_GetVerticalGains(int32_t *kp, int32_t *ki, int32_t *kd);
+void ControlTask_GetStepStats(uint8_t step, VertStepStats *stats);
+void ControlTask_GetSeqStats(SeqStats *stats);
+
+// input events into the control queue. stamp is the DWT cycle count of the edge behind the event
+void ControlTask_SendEvent(InputEvent evt);
+BaseType_t ControlTask_SendEventStamped(InputEvent evt, uint32_t stamp);
+BaseType_t ControlTask_SendEventFromISR(InputEvent evt, uint32_t stamp, BaseType_t *woken);
+
+// edge to ControlTask handling the event, in us (last and worst since boot)
+void ControlTask_GetInputLatency(uint32_t *lastUs, uint32_t *maxUs);
+
+// what woke ControlTask, counts since boot or the last reset. a pass can have several causes
+typedef struct {
+    uint32_t passes;              // times round the loop
+    uint32_t input;               // an input event
+    uint32_t sensor;              // a sensor sample
+    uint32_t mode;                // a mode change from another task
+    uint32_t deadline;            // a deadline the mode asked for (step timing, loop period)
+    uint32_t watchdog;            // nothing, the fallback period ran out
+    uint32_t sinceTick;           // when counting started
+    uint32_t sensorLatLastCyc;    // sample published to ControlTask running, cpu cycles
+    uint32_t sensorLatMaxCyc;
+} ControlWakeStats;
+
+void ControlTask_GetWakeStats(ControlWakeStats *stats);
+void ControlTask_ResetWakeStats(void);
+
+// state accessors for telemetry
+CraneMode ControlTask_GetMode(void);
+// auto is running or a request for it is waiting for ControlTask. call it with the scheduler
+// held off (critical section) to keep ControlTask from starting auto behind your back
+uint8_t ControlTask_AutoActive(void);
+uint8_t ControlTask_GetAutoStep(void);
+UBaseType_t ControlTask_QueueDepth(void);
+
 
 #endif /* INC_USER_CONTROLTASK_H_ */
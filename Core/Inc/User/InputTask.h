@@ -13,27 +13,74 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 
+// every input in one table. a LINE is a wired input (pin label from main.h, on a free exti line):
+// the event it raises when it closes, the one it raises when it opens (OWN(evt) declares it,
+// SHARED(evt) reuses one another line declared, NONE for nothing), the axis and direction a limit
+// switch blocks (DIRSTOP if it isn't one) and, for a three position switch, the line for the other
+// side (it only reports open once both sides are). an EVENT is one no line raises. adding an input is
+// one LINE row plus its pin in cubemx (gpio exti, both edges), InputTask_Init enables its exti irq
+#define INPUT_TABLE(LINE, EVENT) \
+	/*   pin label      on close             on open                     limit axis     blocks   pair        */ \
+	LINE(BUT_VERT,      VERT_BUTTON_PRESSED, OWN(VERT_BUTTON_RELEASED),  AXIS_VERTICAL, DIRSTOP, NONE)        \
+	LINE(BUT_PLAT,      PLAT_BUTTON_PRESSED, OWN(PLAT_BUTTON_RELEASED),  AXIS_VERTICAL, DIRSTOP, NONE)        \
+	LINE(SW_VERT_UP,    VERT_SWITCH_UP,      OWN(VERT_SWITCH_OFF),       AXIS_VERTICAL, DIRSTOP, SW_VERT_DN)  \
+	LINE(SW_VERT_DN,    VERT_SWITCH_DOWN,    SHARED(VERT_SWITCH_OFF),    AXIS_VERTICAL, DIRSTOP, SW_VERT_UP)  \
+	LINE(SW_PLAT_L,     PLAT_SWITCH_LEFT,    OWN(PLAT_SWITCH_OFF),       AXIS_VERTICAL, DIRSTOP, SW_PLAT_R)   \
+	LINE(SW_PLAT_R,     PLAT_SWITCH_RIGHT,   SHARED(PLAT_SWITCH_OFF),    AXIS_VERTICAL, DIRSTOP, SW_PLAT_L)   \
+	/* left is DIRDOWN on the platform servo (Crane_MovePlatformLeft), right is DIRUP */                       \
+	LINE(LIM_SW_LEFT,   LIMIT_LEFT_HIT,      NONE,                       AXIS_PLATFORM, DIRDOWN, NONE)        \
+	LINE(LIM_SW_RIGHT,  LIMIT_RIGHT_HIT,     NONE,                       AXIS_PLATFORM, DIRUP,   NONE)        \
+	/* top and bottom limit switches and the reset button aren't wired, ControlTask still knows them */       \
+	EVENT(RESET_BUTTON)         \
+	EVENT(LIMIT_TOP_HIT)        \
+	EVENT(LIMIT_BOTTOM_HIT)
+
+#define INPUT_IGNORE_EVENT(evt)
+
+// the open column pasted onto a prefix: INPUT_OPEN_EVT_ gives the event, INPUT_OPEN_ENUM_ only
+// declares the ones a line owns
+#define INPUT_OPEN_EVT_OWN(evt)		EVT_##evt
+#define INPUT_OPEN_EVT_SHARED(evt)	EVT_##evt
+#define INPUT_OPEN_EVT_NONE			EVT_NONE
+#define INPUT_OPEN_ENUM_OWN(evt)	EVT_##evt,
+#define INPUT_OPEN_ENUM_SHARED(evt)
+#define INPUT_OPEN_ENUM_NONE
+
 typedef enum {
-	EVT_VERT_BUTTON_PRESSED,
-	EVT_VERT_BUTTON_RELEASED,
-	EVT_PLAT_BUTTON_PRESSED,
-	EVT_PLAT_BUTTON_RELEASED,
-	EVT_VERT_SWITCH_UP,
-	EVT_VERT_SWITCH_DOWN,
-	EVT_VERT_SWITCH_OFF,
-	EVT_PLAT_SWITCH_LEFT,
-	EVT_PLAT_SWITCH_RIGHT,
-	EVT_PLAT_SWITCH_OFF,
-	EVT_RESET_BUTTON,
-	EVT_LIMIT_TOP_HIT,
-	EVT_LIMIT_BOTTOM_HIT,
-	EVT_LIMIT_LEFT_HIT,
-	EVT_LIMIT_RIGHT_HIT
+#define INPUT_ENUM_LINE(label, close, open, axis, dir, pair)	EVT_##close, INPUT_OPEN_ENUM_##open
+#define INPUT_ENUM_EVENT(evt)									EVT_##evt,
+	INPUT_TABLE(INPUT_ENUM_LINE, INPUT_ENUM_EVENT)
+#undef INPUT_ENUM_LINE
+#undef INPUT_ENUM_EVENT
+	EVT_COUNT,
+	EVT_NONE = 0xFF		// an edge with nothing to report
 } InputEvent;
 
-extern QueueHandle_t InputEventQuery;
+// line numbers, also the bit of each line in the input snapshot
+typedef enum {
+#define INPUT_ENUM_ID(label, close, open, axis, dir, pair)		IN_##label,
+	INPUT_TABLE(INPUT_ENUM_ID, INPUT_IGNORE_EVENT)
+#undef INPUT_ENUM_ID
+	INPUT_COUNT,
+	IN_NONE = 0xFF
+} InputLineId;
+
+// what goes through the control queue: the event and the DWT cycle count of the edge behind it
+typedef struct {
+	InputEvent evt;
+	uint32_t stamp;
+} InputEventMsg;
 
+// sets up the edge interrupts' debounce sampler and enables every table line's exti irq, no task of its own
 void InputTask_Init(void);
-void InputTask_Start(void);
+// services every pending table line, called first thing from each exti vector
+void InputTask_EXTI_IRQHandler(void);
+
+// edge to event posted, in us (last and worst since boot), and events posted
+void InputTask_GetLatency(uint32_t *lastUs, uint32_t *maxUs, uint32_t *events);
+// transitions lost to a full control queue since boot
+uint32_t InputTask_GetDropped(void);
+// debounced level of every input, one bit per line in table order
+uint16_t InputTask_GetSnapshot(void);
 
 #endif /* INC_USER_INPUTTASK_H_ */
@@ -10,16 +10,76 @@
 
 #include <stdint.h>
 #include "FreeRTOS.h"
-#include "queue.h"
+#include "task.h"
 
+#define SENSOR_NORM_ONE		10000	// heightNorm full scale
+#define SENSOR_HEIGHT_INVALID	(-1)	// heightUm / heightFiltUm when there is nothing to report
+
+// trigger to publish latency histogram, bucket i counts samples under (1 << i) ms, the last one the rest
+#define SENSOR_LAT_BUCKETS	6
+
+typedef enum {
+	SENSOR_OK = 0,			// echo inside the sensor's range
+	SENSOR_NO_ECHO,			// ping timed out, heightUm and heightNorm are invalid
+	SENSOR_OUT_OF_RANGE,	// echo outside the range, heightUm is the unclamped measurement
+} SensorStatus;
+
+// all lengths are integer micrometres (1 cm = 10000 um), no floats anywhere in the sample
 typedef struct {
-	float heightCm;			// raw height converted to centimeters
-	float heightNorm;		// normalized 0-1
+	int32_t heightUm;		// raw height, SENSOR_HEIGHT_INVALID without an echo
+	uint16_t heightNorm;	// normalized 0-SENSOR_NORM_ONE (saturates out of range)
+	int32_t heightFiltUm;	// median + alpha-beta filtered height, predicted through dropouts
+							// (SENSOR_HEIGHT_INVALID until the first good echo)
+	int32_t velocityUmS;	// filtered vertical velocity, positive = rising
+	uint32_t tick;			// xTaskGetTickCount() when the echo arrived
+	uint8_t status;			// SensorStatus, only SENSOR_OK readings went into the filter
+	uint32_t seq;			// sample number, increments on every publish (0 = none yet)
+	uint32_t cyc;			// DWT cycle count at publish, for latency of whoever acts on it
 } CraneSensorData;
 
+typedef struct {
+	uint16_t periodMs;		// current ping period
+	uint16_t achievedHz;	// samples delivered in the last full second
+	uint32_t echoes;		// pings answered since boot
+	uint32_t timeouts;		// pings with no echo since boot
+	uint32_t outOfRange;	// echoes outside the sensor's range
+	uint32_t outliers;		// in range readings the median threw away
+	uint32_t latencyLastUs;	// trigger to publish, last echo
+	uint32_t latencyMaxUs;
+	uint32_t latencyHist[SENSOR_LAT_BUCKETS];
+	int32_t predictErrUm;	// dead reckoned minus filtered height at the last good echo
+	uint32_t predictErrMaxUm;
+} SensorHealth;
+
 void SensorTask_Init(void);
 
-// external queue so other tasks can consume sensor data
-extern QueueHandle_t sensorQueue;
+// ranging rate follows vertical motion (called by the servo layer when it changes)
+void SensorTask_SetVerticalMoving(uint8_t moving);
+
+// health counters since boot, for the console and telemetry
+void SensorTask_GetHealth(SensorHealth *health);
+
+// height predictor: dead reckons from the last good echo with the commanded vertical speed
+// (um/s, positive = rising), so the controller doesn't have to wait for the next ping.
+// speed is set by the servo layer whenever the vertical pulse changes
+void SensorTask_SetVerticalSpeed(int32_t umPerS);
+// height now, SENSOR_HEIGHT_INVALID before the first good echo or when the last one is too old
+int32_t SensorTask_PredictHeightUm(void);
+
+// filter cost per sample in cpu cycles (last and worst case since boot)
+void SensorTask_GetFilterCycles(uint32_t *last, uint32_t *max);
+
+// average cycles per sample for pulse conversion + filtering, float reference vs integer path
+void SensorTask_Bench(uint16_t samples, uint32_t *floatCycles, uint32_t *fixedCycles);
+
+// latest sample, non-destructive, any number of readers (task context).
+// returns the sample's seq, 0 if nothing has been published yet
+uint32_t SensorTask_GetLatest(CraneSensorData *out);
+
+// wake a task on every publish: sets bits in its notification value (one listener, NULL for none)
+void SensorTask_NotifyOnSample(TaskHandle_t task, uint32_t bits);
+
+// copy the latest sample only if it is newer than *lastSeq (then updates *lastSeq), returns 1 if fresh
+uint8_t SensorTask_ReadIfNew(CraneSensorData *out, uint32_t *lastSeq);
 
 #endif /* INC_USER_SENSORTASK_H_ */
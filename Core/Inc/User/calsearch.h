@@ -0,0 +1,46 @@
+/*
+ * calsearch.h
+ *
+ *  Created on: Dec 11, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_CALSEARCH_H_
+#define INC_USER_CALSEARCH_H_
+
+#include <stdint.h>
+
+// bracketing search for the pulse that gives a speed, one measured run per pass. works on the
+// pulse's offset from the stop pulse and the speed's magnitude, so speed only grows with the
+// offset and one search serves either direction. lo is an offset known to be under the target
+// speed and hi one at or over it, every pass lands between them and replaces one.
+// false position (with the illinois tweak, so an end that never moves doesn't slow it down to
+// bisection speed) converges on a smooth curve in a few passes. plain bisection is for a step
+// like the deadband edge, where interpolating says nothing
+typedef struct {
+	int32_t target;			// speed to find, um/s
+	int32_t tol;			// done once a pass is within this of target, 0 to only stop on width
+	int32_t res;			// done once hi - lo is down to this, us
+	uint8_t bisect;
+
+	int32_t lo, loSpeed;
+	int32_t hi, hiSpeed;
+	int32_t loF, hiF;		// speed - target at each end, halved by the illinois step
+	int8_t side;			// end replaced last pass, -1 lo, 1 hi, 0 none yet
+	int32_t guess;			// first pass goes here if inside the bracket, 0 for none
+
+	uint8_t passes;
+	uint8_t done;
+	int32_t best;			// offset measured closest to target
+	int32_t bestSpeed;
+} CalSearch;
+
+// lo and hi must bracket target (loSpeed < target <= hiSpeed)
+void CalSearch_Init(CalSearch *cs, int32_t target, int32_t tol, int32_t res, uint8_t bisect,
+		int32_t lo, int32_t loSpeed, int32_t hi, int32_t hiSpeed, int32_t guess);
+// offset to measure next
+int32_t CalSearch_Next(CalSearch *cs);
+// what it measured there, returns 1 once the search is done
+uint8_t CalSearch_Feed(CalSearch *cs, int32_t off, int32_t speed);
+
+#endif /* INC_USER_CALSEARCH_H_ */
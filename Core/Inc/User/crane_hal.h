@@ -23,12 +23,44 @@ typedef enum {
 extern uint16_t servo_pwm_forward;
 extern uint16_t servo_pwm_backward;
 extern uint16_t servo_pwm_stop;
+// vertical presets, set by calibration mode
+extern uint16_t servo_pwm_vert_forward;
+extern uint16_t servo_pwm_vert_backward;
 
+// vertical pwm to speed model, piecewise linear between calibrated points.
+// speeds in um/s, positive = rising (so below servo_pwm_stop, the axis is wired flipped)
+#define CRANE_SPEED_POINTS_MAX	12
+
+typedef struct {
+    uint16_t pulse;
+    int32_t umPerS;
+} speed_point_t;
+
+int32_t Crane_VerticalSpeedUmS(uint16_t pulse);
+// add or replace the point for this pulse (calibration), the nearest point goes if the table is full
+void Crane_SetSpeedPoint(uint16_t pulse, int32_t umPerS);
+// replace the whole model, points sorted by pulse with the speed falling (2..CRANE_SPEED_POINTS_MAX).
+// returns 0 and keeps the old one if they aren't
+uint8_t Crane_SetSpeedTable(const speed_point_t *points, uint8_t count);
+// the other way round, the pulse the model says gives this speed (servo_pwm_stop for 0).
+// clamps to the ends of the calibrated span
+uint16_t Crane_VerticalPulseForSpeed(int32_t umPerS);
+
+// closed loop pulses this close to servo_pwm_stop are sent as a plain stop (us)
+#define CRANE_PULSE_DEADBAND	3
+
+
+// axes, for the limit switch stop path
+typedef enum {
+    AXIS_VERTICAL = 0,	// TIM1 CH1
+    AXIS_PLATFORM		// TIM1 CH2
+} axis_t;
 
 // servo command
 typedef struct {
     TIM_HandleTypeDef* htim;
     dir_t servodir;
+    uint16_t pulse;		// 0 for the preset forward/backward speed, else the exact pulse (closed loop)
 } servo_cmd_t;
 
 // external queue for servo commands
@@ -41,10 +73,24 @@ void Crane_HAL_Init(void);
 void Crane_MoveVerticalUp(void);
 void Crane_MoveVerticalDown(void);
 void Crane_StopVertical(void);
+// continuous vertical pulse for a closed loop controller, clamped to the calibrated span and
+// snapped to servo_pwm_stop inside CRANE_PULSE_DEADBAND. a latched limit still refuses it
+void Crane_SetVerticalPulse(uint16_t pulse);
 
 // platform servo control
 void Crane_MovePlatformRight(void);
 void Crane_MovePlatformLeft(void);
 void Crane_StopPlatform(void);
 
+// limit switch safety path, called from the switch's exti isr. writes the stop pulse straight
+// into the axis' CCR and latches that direction as blocked, so the servo task can't drive into the
+// end stop again until the switch releases (Crane_LimitClear), then queues a stop so the servo task
+// and the sensor's predictor know. stamp is the DWT count at the edge
+void Crane_LimitHitFromISR(axis_t axis, dir_t dir, uint32_t stamp);
+void Crane_LimitClear(axis_t axis, dir_t dir);
+uint8_t Crane_LimitLatched(axis_t axis, dir_t dir);
+
+// edge to stop pulse written, cpu cycles (last and worst since boot), and stops taken
+void Crane_GetLimitStopLatency(uint32_t *lastCyc, uint32_t *maxCyc, uint32_t *count);
+
 #endif /* CRANE_HAL_H_ */
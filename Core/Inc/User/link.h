@@ -0,0 +1,30 @@
+/*
+ * link.h
+ *
+ *  Created on: Dec 3, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_LINK_H_
+#define INC_USER_LINK_H_
+
+#include <stdint.h>
+
+// binary frames share usart2 with the text console:
+//   0x00 | COBS( type, payload..., crc16 lo, crc16 hi ) | 0x00
+// crc16 is CCITT-FALSE (poly 0x1021, init 0xFFFF) over type + payload.
+// text between frames never contains 0x00, so the host can tell the two apart.
+
+#define LINK_MAX_PAYLOAD	64
+
+typedef enum {
+	LINK_FRAME_TRACE = 1,		// tokenized trace record (see trace.h)
+	LINK_FRAME_TELEMETRY = 2,	// periodic state snapshot (see telemetry.h)
+} LinkFrameType;
+
+uint16_t link_crc16(const uint8_t *data, uint16_t len, uint16_t crc);
+
+// encode and queue one frame, returns 0 if it was dropped
+uint8_t link_send_frame(uint8_t type, const void *payload, uint16_t len);
+
+#endif /* INC_USER_LINK_H_ */
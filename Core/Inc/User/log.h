@@ -0,0 +1,156 @@
+/*
+ * log.h
+ *
+ *  Created on: Dec 4, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_LOG_H_
+#define INC_USER_LOG_H_
+
+#include <stdint.h>
+
+#include "User/trace.h"
+
+// levelled logging on top of TRACE, with one runtime threshold per module.
+//   LOG_DEBUG(SERVO, "vertical ccr %u", ccr);
+// levels above LOG_COMPILE_LEVEL expand to nothing (no string, no argument evaluation).
+// the rest cost one byte compare against logLevels[] before anything is sent.
+// the level letter and module tag are glued onto the format, e.g. "D SERVO: vertical ccr 1440".
+
+#define LOG_LVL_OFF		0
+#define LOG_LVL_ERROR	1
+#define LOG_LVL_WARN	2
+#define LOG_LVL_INFO	3
+#define LOG_LVL_DEBUG	4
+#define LOG_LVL_TRACE	5
+
+// compile time floor, debug builds keep everything, release builds drop DEBUG and TRACE
+#ifndef LOG_COMPILE_LEVEL
+#ifdef DEBUG
+#define LOG_COMPILE_LEVEL	LOG_LVL_TRACE
+#else
+#define LOG_COMPILE_LEVEL	LOG_LVL_INFO
+#endif
+#endif
+
+// runtime threshold every module starts with
+#define LOG_DEFAULT_LEVEL	LOG_LVL_INFO
+
+typedef enum {
+	LOG_MOD_INPUT,
+	LOG_MOD_CONTROL,
+	LOG_MOD_SERVO,
+	LOG_MOD_SENSOR,
+	LOG_MOD_UART,
+	LOG_MOD_COUNT
+} LogModule;
+
+extern uint8_t logLevels[LOG_MOD_COUNT];
+
+void log_set_level(LogModule mod, uint8_t level);
+uint8_t log_get_level(LogModule mod);
+
+// name lookups for the console, return -1 when the name is unknown
+int log_level_from_name(const char *name);
+int log_module_from_name(const char *name);
+const char *log_level_name(uint8_t level);
+const char *log_module_name(LogModule mod);
+
+// per call site token bucket for conditions that repeat (held switches, stuck inputs).
+// a site may log `burst` lines at once and regains one every `periodMs`. occurrences in between
+// are only counted, the next line that gets through carries " ... repeated N times in X.XXs".
+// if none does, the log timer prints the summary on its own once the period is up, with the
+// arguments of the last occurrence swallowed. the summary takes 3 of the TRACE arguments, so
+// limited sites get at most 3 of their own. call a given site from one task only.
+typedef struct LogLimiter {
+	const char *repeatFmt;		// the site's format with the summary on the end
+	struct LogLimiter *next;	// on the pending list while suppressed != 0
+	uint32_t refillTick;		// tick the bucket was last topped up
+	uint32_t periodTicks;
+	uint32_t firstSuppressed;	// tick of the first occurrence not logged
+	uint32_t lastSuppressed;	// and of the latest
+	uint32_t suppressed;		// occurrences not logged since the last line
+	uint32_t lastArgs[TRACE_MAX_ARGS - 3];	// of the last occurrence not logged
+	uint8_t nargs;
+	uint8_t tokens;
+	uint8_t started;
+	uint8_t pending;
+} LogLimiter;
+
+// starts the timer that prints the summaries nothing else would have
+void log_init(void);
+// one occurrence at a limited site: logs fmt, fmt with the summary, or only counts it
+void log_limited(LogLimiter *lim, const char *fmt, uint8_t burst, uint32_t periodMs, const uint32_t *args, uint8_t nargs);
+// print the summary of every site whose period is up with occurrences still uncounted for
+void log_limit_flush(void);
+
+#define LOG_AT_(lvl, letter, mod, fmt, ...) \
+	do { \
+		if (logLevels[LOG_MOD_ ## mod] >= (lvl)) { \
+			TRACE(letter " " #mod ": " fmt, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+#define LOG_LIMITED_AT_(lvl, letter, mod, burst, periodMs, fmt, ...) \
+	do { \
+		_Static_assert(TRACE_NARGS_(__VA_ARGS__) <= TRACE_MAX_ARGS - 3, "limited log takes 3 arguments at most"); \
+		static const char log_fmt_[] __attribute__((section(".trace_fmt"), used)) = \
+				letter " " #mod ": " fmt; \
+		static const char log_repeat_fmt_[] __attribute__((section(".trace_fmt"), used)) = \
+				letter " " #mod ": " fmt " ... repeated %lu times in %lu.%02lus"; \
+		static LogLimiter log_limiter_ = { .repeatFmt = log_repeat_fmt_ }; \
+		if (logLevels[LOG_MOD_ ## mod] >= (lvl)) { \
+			const uint32_t log_args_[] = { 0 TRACE_MAP_N_(TRACE_NARGS_(__VA_ARGS__))(__VA_ARGS__) }; \
+			log_limited(&log_limiter_, log_fmt_, (burst), (periodMs), &log_args_[1], TRACE_NARGS_(__VA_ARGS__)); \
+		} \
+	} while (0)
+
+#define LOG_NONE_(...)	do { } while (0)
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_ERROR
+#define LOG_ERROR(mod, fmt, ...)	LOG_AT_(LOG_LVL_ERROR, "E", mod, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_LIMITED(mod, burst, periodMs, fmt, ...) \
+	LOG_LIMITED_AT_(LOG_LVL_ERROR, "E", mod, burst, periodMs, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(mod, fmt, ...)	LOG_NONE_()
+#define LOG_ERROR_LIMITED(mod, burst, periodMs, fmt, ...)	LOG_NONE_()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_WARN
+#define LOG_WARN(mod, fmt, ...)		LOG_AT_(LOG_LVL_WARN, "W", mod, fmt, ##__VA_ARGS__)
+#define LOG_WARN_LIMITED(mod, burst, periodMs, fmt, ...) \
+	LOG_LIMITED_AT_(LOG_LVL_WARN, "W", mod, burst, periodMs, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(mod, fmt, ...)		LOG_NONE_()
+#define LOG_WARN_LIMITED(mod, burst, periodMs, fmt, ...)	LOG_NONE_()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_INFO
+#define LOG_INFO(mod, fmt, ...)		LOG_AT_(LOG_LVL_INFO, "I", mod, fmt, ##__VA_ARGS__)
+#define LOG_INFO_LIMITED(mod, burst, periodMs, fmt, ...) \
+	LOG_LIMITED_AT_(LOG_LVL_INFO, "I", mod, burst, periodMs, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(mod, fmt, ...)		LOG_NONE_()
+#define LOG_INFO_LIMITED(mod, burst, periodMs, fmt, ...)	LOG_NONE_()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_DEBUG
+#define LOG_DEBUG(mod, fmt, ...)	LOG_AT_(LOG_LVL_DEBUG, "D", mod, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_LIMITED(mod, burst, periodMs, fmt, ...) \
+	LOG_LIMITED_AT_(LOG_LVL_DEBUG, "D", mod, burst, periodMs, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(mod, fmt, ...)	LOG_NONE_()
+#define LOG_DEBUG_LIMITED(mod, burst, periodMs, fmt, ...)	LOG_NONE_()
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LVL_TRACE
+#define LOG_TRACE(mod, fmt, ...)	LOG_AT_(LOG_LVL_TRACE, "T", mod, fmt, ##__VA_ARGS__)
+#define LOG_TRACE_LIMITED(mod, burst, periodMs, fmt, ...) \
+	LOG_LIMITED_AT_(LOG_LVL_TRACE, "T", mod, burst, periodMs, fmt, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(mod, fmt, ...)	LOG_NONE_()
+#define LOG_TRACE_LIMITED(mod, burst, periodMs, fmt, ...)	LOG_NONE_()
+#endif
+
+#endif /* INC_USER_LOG_H_ */
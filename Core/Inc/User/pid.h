@@ -0,0 +1,35 @@
+/*
+ * pid.h
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_PID_H_
+#define INC_USER_PID_H_
+
+#include <stdint.h>
+
+// integer position loop, position in um and the output a speed in um/s (positive = towards
+// larger positions). gains are x1000 so they tune in small steps without floats:
+//   out = ff + kp*e + ki*integral(e) + kd*(ff - vel)
+// the derivative works on the measured velocity against the feedforward one, so a step in the
+// target doesn't kick it. the integral is kept as its contribution to the output and only grows
+// while that doesn't push further into saturation (anti windup)
+typedef struct {
+	int32_t kp;				// 1/s x1000 (1000 = 1 cm/s per cm of error)
+	int32_t ki;				// 1/s^2 x1000
+	int32_t kd;				// x1000, unitless (velocity error to output)
+	int32_t outMax;			// output saturation either way, um/s
+	int32_t deadbandUm;		// error under this gives no output and holds the integral
+	int32_t iTerm;			// integral contribution, um/s
+	uint8_t saturated;		// last output was clipped
+} Pid;
+
+void Pid_Init(Pid *pid, int32_t kp, int32_t ki, int32_t kd, int32_t outMax, int32_t deadbandUm);
+// clears the integral, call when the loop (re)takes the axis
+void Pid_Reset(Pid *pid);
+// one step, error = target - measured
+int32_t Pid_Update(Pid *pid, int32_t errorUm, int32_t velUmS, int32_t ffUmS, uint32_t dtMs);
+
+#endif /* INC_USER_PID_H_ */
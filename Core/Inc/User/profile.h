@@ -0,0 +1,48 @@
+/*
+ * profile.h
+ *
+ *  Created on: Dec 9, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_PROFILE_H_
+#define INC_USER_PROFILE_H_
+
+#include <stdint.h>
+
+// rest to rest s-curve move, planned once and then read off at control rate. jerk limited ramps
+// up to a cruise speed and symmetric ramps back down, so the load lands at zero speed and zero
+// acceleration. short moves never reach vMax (or aMax) and get a lower peak instead.
+// lengths in um, times in ms, integer maths only
+typedef struct {
+	int32_t vMax;			// cruise speed limit, um/s
+	int32_t aMax;			// um/s^2
+	int32_t jMax;			// um/s^3
+
+	// the planned move
+	int32_t start;
+	int32_t target;
+	int32_t dir;			// +1 or -1
+	int32_t vPeak;			// um/s
+	int32_t aPeak;			// um/s^2
+	uint32_t tJerk;			// each jerk ramp
+	uint32_t tAcc;			// whole speed up (and slow down)
+	uint32_t tCruise;
+	uint32_t elapsed;
+
+	// setpoint at elapsed
+	int32_t pos;			// um
+	int32_t vel;			// um/s, the controller's feedforward
+} Profile;
+
+void Profile_Init(Profile *prof, int32_t vMax, int32_t aMax, int32_t jMax);
+// plan a move from rest at start to rest at target, the setpoint starts at start
+void Profile_Start(Profile *prof, int32_t start, int32_t target);
+// advance the setpoint by dtMs
+void Profile_Step(Profile *prof, uint32_t dtMs);
+// setpoint is at the target and stopped
+uint8_t Profile_Done(const Profile *prof);
+// planned length of the move, ms
+uint32_t Profile_Duration(const Profile *prof);
+
+#endif /* INC_USER_PROFILE_H_ */
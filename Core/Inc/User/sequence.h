@@ -0,0 +1,83 @@
+/*
+ * sequence.h
+ *
+ *  Created on: Dec 10, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_SEQUENCE_H_
+#define INC_USER_SEQUENCE_H_
+
+#include <stdint.h>
+
+#include "User/crane_hal.h"
+
+#define SEQ_MAX_STEPS		16
+
+// what a height move is allowed, the sensor's valid span and sane tolerances/timeouts
+#define SEQ_HEIGHT_MIN_UM	10000
+#define SEQ_HEIGHT_MAX_UM	200000
+#define SEQ_TOL_MIN_UM		500
+#define SEQ_TOL_MAX_UM		20000
+#define SEQ_TIMEOUT_MIN_MS	100
+#define SEQ_TIMEOUT_MAX_MS	60000
+
+// vertical controller a height step uses to reach its height
+typedef enum {
+	VERT_CTRL_BANG = 0,		// preset speed until inside tolerance, then stop
+	VERT_CTRL_PID,			// closed loop pulse (pid.h) straight at the target, done once settled
+	VERT_CTRL_PROFILE		// the same loop following an s-curve setpoint (profile.h)
+} VertCtrl;
+
+typedef enum {
+	SEQ_MOVE_HEIGHT = 0,	// vertical to target um, within tolUm
+	SEQ_MOVE_TIMED,			// run for |target| ms
+	SEQ_MOVE_LIMIT			// run until the limit switch that way latches
+} SeqMove;
+
+// when a step may start. steps start in table order and each axis runs one step at a time,
+// so anything but AFTER lets a step overlap whatever still runs on the other axis
+typedef enum {
+	SEQ_START_AFTER = 0,	// once every earlier step is done
+	SEQ_START_WITH,			// as soon as its axis is free
+	SEQ_START_ABOVE,		// axis free and the height at or above clearUm
+	SEQ_START_BELOW			// axis free and the height at or below clearUm
+} SeqStart;
+
+// one step. for timed and limit moves the sign of target is the direction:
+// positive is rising on the vertical axis and right on the platform
+typedef struct {
+	uint8_t axis;			// axis_t
+	uint8_t move;			// SeqMove
+	uint8_t ctrl;			// VertCtrl, height moves only
+	uint8_t start;			// SeqStart
+	int32_t target;
+	int32_t tolUm;			// height moves only
+	uint32_t timeoutMs;		// a step still going after this aborts the sequence
+	int32_t clearUm;		// SEQ_START_ABOVE/BELOW only
+} SeqStep;
+
+typedef struct {
+	SeqStep steps[SEQ_MAX_STEPS];
+	uint8_t count;
+} SeqTable;
+
+// active table starts as the built in route
+void Seq_Init(void);
+
+// the table auto mode runs (RAM)
+SeqTable *Seq_Active(void);
+// the table the console builds up, checked and swapped in by Seq_Load
+SeqTable *Seq_Staging(void);
+
+// NULL if the table can run, else what is wrong with step *badStep
+const char *Seq_Validate(const SeqTable *table, uint8_t *badStep);
+// validate the staging table and make it the active one. refused while auto mode runs or is requested
+const char *Seq_Load(uint8_t *badStep);
+// back to the built in route (also refused while auto runs)
+uint8_t Seq_LoadDefault(void);
+
+// servo direction a timed or limit step drives in
+dir_t Seq_StepDir(const SeqStep *step);
+
+#endif /* INC_USER_SEQUENCE_H_ */
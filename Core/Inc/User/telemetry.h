@@ -0,0 +1,44 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Dec 4, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_TELEMETRY_H_
+#define INC_USER_TELEMETRY_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_MIN_HZ	10
+#define TELEMETRY_MAX_HZ	200
+
+// payload of a LINK_FRAME_TELEMETRY frame (little endian, packed).
+typedef struct __attribute__((packed)) {
+	uint16_t seq;				// frame counter, gaps show dropped frames
+	uint32_t tick;				// xTaskGetTickCount() when sampled
+	int32_t heightUm;			// latest sensor reading
+	uint16_t heightNorm;		// 0-SENSOR_NORM_ONE
+	uint8_t mode;				// CraneMode
+	uint8_t autoStep;
+	uint16_t ccr1;				// TIM1 CH1 pulse (vertical servo, us)
+	uint16_t ccr2;				// TIM1 CH2 pulse (platform servo, us)
+	uint8_t controlQueueDepth;
+	uint8_t servoQueueDepth;
+	int32_t heightFiltUm;		// filtered height and velocity (see SensorTask.h)
+	int32_t velocityUmS;
+	uint8_t sensorStatus;		// SensorStatus of the latest ping
+	uint16_t echoTimeouts;		// sensor health counters since boot (low 16 bits, wrap)
+	uint16_t outOfRange;
+	uint16_t outliers;
+	uint8_t sampleHz;			// samples in the last full second
+	uint16_t latencyUs;			// trigger to publish, last echo
+} TelemetryFrame;
+
+void Telemetry_Init(void);
+
+// 0 stops the stream, otherwise clamped to TELEMETRY_MIN_HZ..TELEMETRY_MAX_HZ
+void Telemetry_SetRate(uint16_t hz);
+uint16_t Telemetry_GetRate(void);
+
+#endif /* INC_USER_TELEMETRY_H_ */
@@ -0,0 +1,65 @@
+/*
+ * trace.h
+ *
+ *  Created on: Dec 3, 2025
+ *      Author: ryang
+ */
+
+#ifndef INC_USER_TRACE_H_
+#define INC_USER_TRACE_H_
+
+#include <stdint.h>
+
+// tokenized logging: nothing is formatted on the target.
+// each call site keeps its format string in the .trace_fmt section (never loaded into flash)
+// and sends a link frame holding the string's offset, a tick timestamp and the raw arguments.
+// Tools/crane_trace rebuilds the text from the elf (or a table dumped from it).
+// call from task context only.
+//
+// arguments are sent as 32 bit words: integers as-is, float/double as float bits.
+// supported conversions are %d %i %u %x %X %c and %f %e %g, at most TRACE_MAX_ARGS of them.
+// strings and pointers are not supported. a newline is added by the decoder.
+
+#define TRACE_MAX_ARGS	6
+
+// payload layout of a LINK_FRAME_TRACE frame (little endian, packed)
+typedef struct __attribute__((packed)) {
+	uint16_t fmtId;			// offset of the format string in .trace_fmt
+	uint32_t tick;			// xTaskGetTickCount() at the call
+	uint32_t args[TRACE_MAX_ARGS];	// only the used words are sent
+} TraceRecord;
+
+void trace_emit(uint16_t fmtId, const uint32_t *args, uint8_t nargs);
+
+static inline uint32_t trace_float_bits_(float f)
+{
+	union { float f; uint32_t u; } v = { .f = f };
+	return v.u;
+}
+
+#define TRACE_ARG_(x) _Generic((x), \
+		float: trace_float_bits_((float)(x)), \
+		double: trace_float_bits_((float)(x)), \
+		default: (uint32_t)(x))
+
+#define TRACE_NARGS_(...) TRACE_NARGS_N_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define TRACE_NARGS_N_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+
+#define TRACE_MAP_0_()
+#define TRACE_MAP_1_(a)					, TRACE_ARG_(a)
+#define TRACE_MAP_2_(a, b)				TRACE_MAP_1_(a) TRACE_MAP_1_(b)
+#define TRACE_MAP_3_(a, b, c)			TRACE_MAP_2_(a, b) TRACE_MAP_1_(c)
+#define TRACE_MAP_4_(a, b, c, d)		TRACE_MAP_3_(a, b, c) TRACE_MAP_1_(d)
+#define TRACE_MAP_5_(a, b, c, d, e)		TRACE_MAP_4_(a, b, c, d) TRACE_MAP_1_(e)
+#define TRACE_MAP_6_(a, b, c, d, e, f)	TRACE_MAP_5_(a, b, c, d, e) TRACE_MAP_1_(f)
+#define TRACE_MAP_CAT_(n)				TRACE_MAP_ ## n ## _
+#define TRACE_MAP_N_(n)					TRACE_MAP_CAT_(n)
+
+#define TRACE(fmt, ...) \
+	do { \
+		static const char trace_fmt_[] __attribute__((section(".trace_fmt"), used)) = fmt; \
+		const uint32_t trace_args_[] = { 0 TRACE_MAP_N_(TRACE_NARGS_(__VA_ARGS__))(__VA_ARGS__) }; \
+		trace_emit((uint16_t)(uintptr_t)trace_fmt_, &trace_args_[1], TRACE_NARGS_(__VA_ARGS__)); \
+	} while (0)
+
+#endif /* INC_USER_TRACE_H_ */
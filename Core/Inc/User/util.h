@@ -8,10 +8,24 @@
 #ifndef INC_USER_UTIL_H_
 #define INC_USER_UTIL_H_
 
+#include <stdint.h>
+
 void util_init();
 
+// non-blocking prints, bytes are copied into the usart2 dma ring and the call returns right away
 void print_str(char * str);
 void print_str_ISR(char * str);
-void print_str_unsafe(char * str);
+
+// raw binary write through the same ring (used by link frames), returns 0 if dropped
+uint16_t print_bytes(const uint8_t *data, uint16_t len);
+
+// change the usart2 baud rate once pending output has drained, returns 0 if it didn't drain
+uint8_t util_set_baud(uint32_t baud);
+
+// usart2 error callback hook, restarts a transmit the error aborted (isr context)
+void util_tx_error(void);
+
+// number of messages dropped because the transmit ring was full
+uint32_t print_get_dropped(void);
 
 #endif /* INC_USER_UTIL_H_ */
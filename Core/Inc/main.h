@@ -61,28 +61,28 @@ void Error_Handler(void);
 /* Private defines -----------------------------------------------------------*/
 #define B1_Pin GPIO_PIN_13
 #define B1_GPIO_Port GPIOC
-#define SW_VERT_UP_Pin GPIO_PIN_0
-#define SW_VERT_UP_GPIO_Port GPIOC
-#define SW_VERT_DN_Pin GPIO_PIN_1
-#define SW_VERT_DN_GPIO_Port GPIOC
+#define B1_EXTI_IRQn EXTI15_10_IRQn
 #define SW_PLAT_L_Pin GPIO_PIN_2
 #define SW_PLAT_L_GPIO_Port GPIOC
+#define SW_PLAT_L_EXTI_IRQn EXTI2_IRQn
 #define SW_PLAT_R_Pin GPIO_PIN_3
 #define SW_PLAT_R_GPIO_Port GPIOC
+#define SW_PLAT_R_EXTI_IRQn EXTI3_IRQn
 #define BUT_VERT_Pin GPIO_PIN_0
 #define BUT_VERT_GPIO_Port GPIOA
+#define BUT_VERT_EXTI_IRQn EXTI0_IRQn
 #define BUT_PLAT_Pin GPIO_PIN_1
 #define BUT_PLAT_GPIO_Port GPIOA
+#define BUT_PLAT_EXTI_IRQn EXTI1_IRQn
 #define USART_TX_Pin GPIO_PIN_2
 #define USART_TX_GPIO_Port GPIOA
 #define USART_RX_Pin GPIO_PIN_3
 #define USART_RX_GPIO_Port GPIOA
 #define LIM_SW_LEFT_Pin GPIO_PIN_4
 #define LIM_SW_LEFT_GPIO_Port GPIOA
+#define LIM_SW_LEFT_EXTI_IRQn EXTI4_IRQn
 #define LD2_Pin GPIO_PIN_5
 #define LD2_GPIO_Port GPIOA
-#define LIM_SW_RIGHT_Pin GPIO_PIN_0
-#define LIM_SW_RIGHT_GPIO_Port GPIOB
 #define VERT_SERVO_Pin GPIO_PIN_8
 #define VERT_SERVO_GPIO_Port GPIOA
 #define HOR_SERVO_Pin GPIO_PIN_9
@@ -91,13 +91,25 @@ void Error_Handler(void);
 #define TMS_GPIO_Port GPIOA
 #define TCK_Pin GPIO_PIN_14
 #define TCK_GPIO_Port GPIOA
+#define SW_VERT_UP_Pin GPIO_PIN_10
+#define SW_VERT_UP_GPIO_Port GPIOC
+#define SW_VERT_UP_EXTI_IRQn EXTI15_10_IRQn
+#define SW_VERT_DN_Pin GPIO_PIN_11
+#define SW_VERT_DN_GPIO_Port GPIOC
+#define SW_VERT_DN_EXTI_IRQn EXTI15_10_IRQn
+#define LIM_SW_RIGHT_Pin GPIO_PIN_12
+#define LIM_SW_RIGHT_GPIO_Port GPIOC
+#define LIM_SW_RIGHT_EXTI_IRQn EXTI15_10_IRQn
 #define SWO_Pin GPIO_PIN_3
 #define SWO_GPIO_Port GPIOB
+#define US_TRIG_Pin GPIO_PIN_6
+#define US_TRIG_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 
 extern TIM_HandleTypeDef htim1;
 extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
 
 /* USER CODE END Private defines */
 
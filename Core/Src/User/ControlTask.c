@@ -9,20 +9,66 @@
 #include "User/util.h"
 #include "User/crane_hal.h"
 #include "User/SensorTask.h"
+#include "User/log.h"
+#include "User/pid.h"
+#include "User/profile.h"
+#include "User/sequence.h"
+#include "User/calsearch.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
-#include <stdio.h>
+#include <string.h>
 
+// ControlTask sleeps until something needs it: an input event, a sensor sample, a mode change
+// from another task, or the next deadline the current mode asks for. closed loop vertical moves
+// ask for one every period, nothing else polls. the watchdog period is the fallback wake
 #define CONTROL_TASK_PERIOD_MS 20
-
-// auto mode constants
-#define AUTO_BASE_CM         6.0f   // first target height
-#define AUTO_TOL_CM           0.5f   // tolerance around target
-
-// state machine for auto mode
+#define CONTROL_WATCHDOG_MS   250
+
+// ControlTask's notification bits
+#define CONTROL_WAKE_INPUT    (1U << 0)   // event in controlQueue
+#define CONTROL_WAKE_SENSOR   (1U << 1)   // sample published
+#define CONTROL_WAKE_MODE     (1U << 2)   // mode, gains or a step's controller requested by another task
+#define CONTROL_WAKE_ALL      (CONTROL_WAKE_INPUT | CONTROL_WAKE_SENSOR | CONTROL_WAKE_MODE)
+
+#define CONTROL_REQ_NONE      0xFF        // no mode or step controller requested
+
+// auto/cal mode constants, heights in micrometres (integer math keeps this task off the fpu)
+#define AUTO_SETTLE_MS         200   // closed loop: inside tolerance this long before a step is done
+
+// vertical loop defaults, see pid.h for units. the output limit leaves the loop some room
+// above the profile's cruise speed to catch up with the setpoint
+#define VERT_PID_KP           1500   // 1 cm off -> 1.5 cm/s
+#define VERT_PID_KI            400
+#define VERT_PID_KD            150
+#define VERT_PID_OUT_MAX     36000
+#define VERT_PID_DEADBAND     1000   // 1 mm
+
+// profiled moves cruise faster than the 2 cm/s bang-bang limit, the s-curve is what keeps
+// the landing soft (zero speed and acceleration on arrival)
+#define VERT_PROFILE_VMAX    30000   // um/s
+#define VERT_PROFILE_AMAX    50000   // um/s^2
+#define VERT_PROFILE_JMAX   300000   // um/s^3
+
+// calibration, speeds are magnitudes and pulses offsets from servo_pwm_stop (calsearch.h)
+#define CAL_TARGET_UM_S      16000   // presets run at 80% of the 2 cm/s limit
+#define CAL_TOL_UM_S          1000
+#define CAL_CREEP_UM_S        1000   // slower than this counts as not moving (deadband)
+#define CAL_SPAN_US            180   // searched from the stop pulse out to here, either way
+#define CAL_RES_US     CRANE_PULSE_DEADBAND   // deadband edge found to this, the loop can't send finer
+#define CAL_MAX_PASSES           8   // per search
+#define CAL_SWEEP_US            10   // linear sweep step the pass count is compared with
+#define CAL_MAX_POINTS          20   // pulses kept per direction
+#define CAL_LOW_UM           50000   // runs stay between these heights
+#define CAL_HIGH_UM         130000
+#define CAL_RUN_UM           30000   // measured distance
+#define CAL_ROOM_UM          15000   // travel left for spin up and stopping
+#define CAL_SPINUP_MS          300   // not measured
+#define CAL_STALL_MS          1500   // still under creep speed here, the run is a stall
+#define CAL_RUN_MAX_MS        4000   // slow runs are measured over whatever they covered by then
+
+// cal mode's pass, and in auto the latest step of the sequence table (sequence.h) started
 static uint8_t auto_step = 0;
-static TickType_t auto_step_start = 0;
 
 // manual mode states
 typedef enum {
@@ -48,67 +94,306 @@ static Direction platSwitchDir = DIR_NONE;
 static uint8_t platButtonHeld = 0;
 static Direction platCurrentMotion = DIR_NONE;
 
-// auto mode state tracking
-static uint8_t autoStateEntry = 1;
+// last sensor sample cal mode has consumed
+static uint32_t calSensorSeq = 0;
 
-// external sensor queue for sensor readings
-extern QueueHandle_t sensorQueue;
+// calibration state
+#define CAL_DIR_UP      0
+#define CAL_DIR_DOWN    1
+
+typedef enum {
+    CAL_PHASE_FAR = 0,     // far end of the span, the search's upper bracket
+    CAL_PHASE_SPEED,       // pulse for CAL_TARGET_UM_S
+    CAL_PHASE_DEADBAND,    // deadband edge
+    CAL_PHASE_DONE
+} CalPhase;
+
+typedef enum {
+    CAL_MOVE_POSITION = 0, // to where the next run fits, then start it
+    CAL_MOVE_SPINUP,
+    CAL_MOVE_RUN
+} CalMove;
+
+typedef struct {
+    uint8_t phase;                      // CalPhase
+    CalSearch search;
+    int32_t minMoving;                  // narrowest offset that moved
+    int32_t maxStall;                   // widest that didn't
+    int32_t conv, convSpeed;            // pulse offset for the target, and what it measured
+    int32_t edge;                       // widest offset inside the deadband
+    uint8_t nPoints;                    // every pulse that moved, for the model
+    int32_t pointOff[CAL_MAX_POINTS];
+    int32_t pointSpeed[CAL_MAX_POINTS];
+} CalDir;
+
+static CalDir calDirs[2];
+static uint8_t calDir = CAL_DIR_UP;     // direction of the current pass
+static uint8_t calMove = CAL_MOVE_POSITION;
+static uint8_t calReposition = 0;       // on the way to where a run fits
+static uint8_t calPasses = 0;
+static int32_t calOff = 0;              // offset being measured
+static uint32_t calRunStart = 0;        // sample tick
+static int32_t calRunFromUm = 0;
+
+// sequence engine, one step at a time per axis
+#define SEQ_NONE    0xFF
+static uint8_t seqNext = 0;                                   // next step to start
+static uint8_t seqPending = 0;                                // seqNext may start, waiting on the sensor
+static uint8_t seqRunning[2] = { SEQ_NONE, SEQ_NONE };       // step on each axis_t
+static TickType_t seqStepStart[SEQ_MAX_STEPS];
+static dir_t seqLimitExpect[2] = { DIRSTOP, DIRSTOP };      // limit a limit step on each axis_t is heading for
+
+// sequence engine measurements
+static VertStepStats autoStepStats[SEQ_MAX_STEPS];
+static SeqStats seqStats;
+static TickType_t seqStartTick = 0;
+static uint32_t seqSerialMs = 0;          // this run's step times added up
+static uint32_t seqTransitionStamp = 0;   // DWT count when the previous step finished, 0 if none
+
+// vertical move in progress
+static Pid vertPid;
+static Profile vertProfile;
+static uint16_t vertLoopPulse = 0;      // last pulse the loop sent, 0 when it isn't driving
+static TickType_t vertLastTick = 0;
+static TickType_t vertInTolSince = 0;   // 0 while outside tolerance
+static int32_t vertStartUm = 0;
+static int32_t vertOvershootUm = 0;
 
 static void ControlTask(void *arg);
 static void updateVerticalMotion(void);
 static void updatePlatformMotion(void);
 static void updateAutoMode(void);
+static void autoInputEvent(InputEvent evt);
+static void updateCalMode(void);
+static void calStart(void);
+static void verticalStop(void);
+static void applyMode(CraneMode mode);
+
+// edge to handled latency, cpu cycles
+static uint32_t inputLatencyLastCyc = 0;
+static uint32_t inputLatencyMaxCyc = 0;
+
+// requests from other tasks (the console). they only leave the request here and notify,
+// ControlTask applies them at the top of its next pass since it owns the state they change
+static volatile uint8_t modeRequest = CONTROL_REQ_NONE;                 // CraneMode
+static volatile uint8_t stepCtrlRequest[SEQ_MAX_STEPS];                 // VertCtrl per step
+static volatile uint8_t gainsRequested = 0;
+static int32_t gainsRequest[3];                                         // kp, ki, kd
+
+// next wake, set up fresh every pass: the watchdog unless a mode asks for sooner
+static TickType_t passTick = 0;         // tick the pass started
+static TickType_t wakeIn = 0;           // ticks after passTick
+static uint8_t wakeForDeadline = 0;     // wakeIn came from a deadline, not the watchdog
+static ControlWakeStats wakeStats;
 
 // helper for sending events to control queue
 void ControlTask_SendEvent(InputEvent evt)
 {
-    if (controlQueue) {
-        xQueueSend(controlQueue, &evt, 0);
+    ControlTask_SendEventStamped(evt, DWT->CYCCNT);
+}
+
+BaseType_t ControlTask_SendEventStamped(InputEvent evt, uint32_t stamp)
+{
+    InputEventMsg msg = { evt, stamp };
+
+    if (!controlQueue || xQueueSend(controlQueue, &msg, 0) != pdPASS) {
+        return pdFAIL;
     }
+    xTaskNotify(controlTaskHandle, CONTROL_WAKE_INPUT, eSetBits);
+    return pdPASS;
+}
+
+BaseType_t ControlTask_SendEventFromISR(InputEvent evt, uint32_t stamp, BaseType_t *woken)
+{
+    InputEventMsg msg = { evt, stamp };
+
+    if (!controlQueue || xQueueSendFromISR(controlQueue, &msg, woken) != pdPASS) {
+        return pdFAIL;
+    }
+    xTaskNotifyFromISR(controlTaskHandle, CONTROL_WAKE_INPUT, eSetBits, woken);
+    return pdPASS;
+}
+
+void ControlTask_GetInputLatency(uint32_t *lastUs, uint32_t *maxUs)
+{
+    uint32_t cycPerUs = SystemCoreClock / 1000000;
+
+    *lastUs = inputLatencyLastCyc / cycPerUs;
+    *maxUs = inputLatencyMaxCyc / cycPerUs;
 }
 
-// helper for setting mode for control operations
+// helper for setting mode for control operations. from another task it's a request, ControlTask
+// (the higher priority) picks it up as soon as the notify lands
 void ControlTask_SetMode(CraneMode mode)
+{
+    if (controlTaskHandle && xTaskGetCurrentTaskHandle() != controlTaskHandle) {
+        modeRequest = mode;
+        xTaskNotify(controlTaskHandle, CONTROL_WAKE_MODE, eSetBits);
+        return;
+    }
+    applyMode(mode);
+}
+
+// inputs only send events when they change, so a switch still thrown or a button still held
+// from before the mode change has nothing new to say. read them off the debounced levels
+static void manualSeed(uint16_t levels)
+{
+    vertButtonHeld = (levels >> IN_BUT_VERT) & 1U;
+    platButtonHeld = (levels >> IN_BUT_PLAT) & 1U;
+
+    if (levels & (1U << IN_SW_VERT_UP)) vertSwitchDir = DIR_UP;
+    else if (levels & (1U << IN_SW_VERT_DN)) vertSwitchDir = DIR_DOWN;
+
+    if (levels & (1U << IN_SW_PLAT_L)) platSwitchDir = DIR_LEFT;
+    else if (levels & (1U << IN_SW_PLAT_R)) platSwitchDir = DIR_RIGHT;
+}
+
+// the mode switch itself, ControlTask context (or before it runs)
+static void applyMode(CraneMode mode)
 {
     currentMode = mode; // change mode
 
-    // full reset of motion state when mode changes
+    // full reset of motion state when mode changes, manual picks up what is held right now
     vertButtonHeld = 0;
     platButtonHeld = 0;
     vertSwitchDir = DIR_NONE;
     platSwitchDir = DIR_NONE;
     vertCurrentMotion = DIR_NONE;
     platCurrentMotion = DIR_NONE;
+    if (mode == MODE_MANUAL) {
+        manualSeed(InputTask_GetSnapshot());
+    }
 
     // stop movement of crane
-    Crane_StopVertical();
+    verticalStop();
     Crane_StopPlatform();
 
+    // a limit step's hit still on its way through the debounce stays expected, the rest are void
+    for (uint8_t axis = AXIS_VERTICAL; axis <= AXIS_PLATFORM; axis++) {
+        if (seqLimitExpect[axis] != DIRSTOP && !Crane_LimitLatched((axis_t)axis, seqLimitExpect[axis])) {
+            seqLimitExpect[axis] = DIRSTOP;
+        }
+    }
+
     // reset auto states
     if (mode == MODE_AUTO) {
         auto_step = 0;
-        autoStateEntry = 1;
+        seqStartTick = xTaskGetTickCount();
+        seqTransitionStamp = 0;
+        seqNext = 0;
+        seqPending = 0;
+        seqRunning[AXIS_VERTICAL] = SEQ_NONE;
+        seqRunning[AXIS_PLATFORM] = SEQ_NONE;
+        seqSerialMs = 0;
+    } else if (mode == MODE_CAL) {
+        auto_step = 0;
+        calStart();
     }
 
+    // only auto and cal act on sensor samples, the rest would just wake up for the keep-alive pings
+    SensorTask_NotifyOnSample((mode == MODE_AUTO || mode == MODE_CAL) ? controlTaskHandle : NULL, CONTROL_WAKE_SENSOR);
+
     // status message for mode change
     switch (mode) {
         case MODE_MANUAL:
-            print_str("Mode: MANUAL\r\n");
+            LOG_INFO(CONTROL, "Mode: MANUAL");
             break;
         case MODE_AUTO:
-            print_str("Mode: AUTO\r\n");
+            LOG_INFO(CONTROL, "Mode: AUTO");
             break;
         case MODE_CAL:
-            print_str("Mode: CAL\r\n");
+            LOG_INFO(CONTROL, "Mode: CAL");
         case MODE_BLOCKED:
-        	print_str("Mode: BLOCKED\r\n");
+        	LOG_INFO(CONTROL, "Mode: BLOCKED");
             break;
     }
 }
 
+CraneMode ControlTask_GetMode(void)
+{
+    return currentMode;
+}
+
+uint8_t ControlTask_AutoActive(void)
+{
+    return currentMode == MODE_AUTO || modeRequest == MODE_AUTO;
+}
+
+uint8_t ControlTask_GetAutoStep(void)
+{
+    return auto_step;
+}
+
+void ControlTask_SetStepController(uint8_t step, VertCtrl ctrl)
+{
+    if (step >= SEQ_MAX_STEPS) {
+        return;
+    }
+    stepCtrlRequest[step] = ctrl;
+    if (controlTaskHandle) {
+        xTaskNotify(controlTaskHandle, CONTROL_WAKE_MODE, eSetBits);
+    }
+}
+
+void ControlTask_SetVerticalGains(int32_t kp, int32_t ki, int32_t kd)
+{
+    taskENTER_CRITICAL();
+    gainsRequest[0] = kp;
+    gainsRequest[1] = ki;
+    gainsRequest[2] = kd;
+    gainsRequested = 1;
+    taskEXIT_CRITICAL();
+    if (controlTaskHandle) {
+        xTaskNotify(controlTaskHandle, CONTROL_WAKE_MODE, eSetBits);
+    }
+}
+
+void ControlTask_GetVerticalGains(int32_t *kp, int32_t *ki, int32_t *kd)
+{
+    *kp = vertPid.kp;
+    *ki = vertPid.ki;
+    *kd = vertPid.kd;
+}
+
+void ControlTask_GetSeqStats(SeqStats *stats)
+{
+    *stats = seqStats;
+}
+
+void ControlTask_GetStepStats(uint8_t step, VertStepStats *stats)
+{
+    if (step < SEQ_MAX_STEPS) {
+        *stats = autoStepStats[step];
+    }
+}
+
+void ControlTask_GetWakeStats(ControlWakeStats *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = wakeStats;
+    taskEXIT_CRITICAL();
+}
+
+void ControlTask_ResetWakeStats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&wakeStats, 0, sizeof(wakeStats));
+    wakeStats.sinceTick = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+}
+
+UBaseType_t ControlTask_QueueDepth(void)
+{
+    return controlQueue ? uxQueueMessagesWaiting(controlQueue) : 0;
+}
+
 void ControlTask_Init(void)
 {
-    controlQueue = xQueueCreate(20, sizeof(InputEvent));
+    Seq_Init();
+    Pid_Init(&vertPid, VERT_PID_KP, VERT_PID_KI, VERT_PID_KD, VERT_PID_OUT_MAX, VERT_PID_DEADBAND);
+    Profile_Init(&vertProfile, VERT_PROFILE_VMAX, VERT_PROFILE_AMAX, VERT_PROFILE_JMAX);
+    memset((void *)stepCtrlRequest, CONTROL_REQ_NONE, sizeof(stepCtrlRequest));
+    controlQueue = xQueueCreate(20, sizeof(InputEventMsg));
     xTaskCreate(
         ControlTask,
         "ControlTask",
@@ -119,6 +404,57 @@ void ControlTask_Init(void)
     );
 }
 
+// what other tasks asked for since the last pass, mode last so it starts with the new settings
+static void applyRequests(void)
+{
+    SeqTable *table = Seq_Active();
+    uint8_t ctrls[SEQ_MAX_STEPS];
+    int32_t gains[3];
+    uint8_t newGains;
+    uint8_t mode;
+
+    taskENTER_CRITICAL();
+    newGains = gainsRequested;
+    gainsRequested = 0;
+    memcpy(gains, gainsRequest, sizeof(gains));
+    memcpy(ctrls, (const void *)stepCtrlRequest, sizeof(ctrls));
+    memset((void *)stepCtrlRequest, CONTROL_REQ_NONE, sizeof(stepCtrlRequest));
+    mode = modeRequest;
+    modeRequest = CONTROL_REQ_NONE;
+    taskEXIT_CRITICAL();
+
+    if (newGains) {
+        vertPid.kp = gains[0];
+        vertPid.ki = gains[1];
+        vertPid.kd = gains[2];
+        Pid_Reset(&vertPid);
+    }
+
+    for (uint8_t i = 0; i < table->count; i++) {
+        if (ctrls[i] != CONTROL_REQ_NONE) {
+            table->steps[i].ctrl = ctrls[i];
+        }
+    }
+
+    if (mode != CONTROL_REQ_NONE) {
+        applyMode((CraneMode)mode);
+    }
+}
+
+// wake no later than tick at (the earliest asked for this pass wins)
+static void controlWakeAt(TickType_t at)
+{
+    TickType_t in = at - passTick;
+
+    if ((int32_t)in < 0) {
+        in = 0; // already due
+    }
+    if (in < wakeIn) {
+        wakeIn = in;
+        wakeForDeadline = 1;
+    }
+}
+
 // manual mode vertical motion helper
 static void updateVerticalMotion(void)
 {
@@ -168,229 +504,422 @@ static void updatePlatformMotion(void)
 }
 
 
-// auto mode state machine
-static void updateAutoMode(void)
-{
-    CraneSensorData s;
-    if (xQueueReceive(sensorQueue, &s, 0) != pdPASS) {
-        return;  // return if no fresh sensor reading
-    }
-
-    float h = s.heightCm;
+// ---------------------------------------
+// vertical moves for auto mode
+// ---------------------------------------
 
-    // check if manual input received, if so, switch to manual mode
-    InputEvent evt;
-    if (xQueueReceive(controlQueue, &evt, 0) == pdPASS) {
-        print_str("AUTO: Manual input detected! Resetting to MANUAL mode\r\n");
-        Crane_StopVertical();
-        Crane_StopPlatform();
-        auto_step = 0;
-        autoStateEntry = 1;
-        ControlTask_SetMode(MODE_MANUAL);
-        return;  // exit auto mode state machine
-    }
+// stop the vertical axis whichever controller had it
+static void verticalStop(void)
+{
+    Crane_StopVertical();
+    vertLoopPulse = 0;
+    vertInTolSince = 0;
+}
 
+// called on a step's entry, before the first autoVerticalTo
+static void verticalBegin(int32_t h, int32_t target)
+{
+    Pid_Reset(&vertPid);
+    Profile_Start(&vertProfile, h, target);
+    vertLastTick = xTaskGetTickCount();
+    vertInTolSince = 0;
+    vertStartUm = h;
+    vertOvershootUm = 0;
+}
 
-    switch (auto_step) {
+// drive toward the step's height with its controller, returns 1 once done (axis stopped).
+// bang-bang runs at the preset speed and is done on entering tolerance. the pid turns the error
+// into a speed, the calibrated model turns that into a pulse, and it is done after holding inside
+// tolerance for AUTO_SETTLE_MS. profiled, the pid follows the s-curve setpoint (with its speed as
+// feedforward) instead of the target itself, and holding only counts once the profile has arrived.
+// either way the overshoot past the target and the time taken are kept
+static uint8_t autoVerticalTo(const SeqStep *step, uint8_t idx, int32_t h)
+{
+    TickType_t now = xTaskGetTickCount();
+    int32_t target = step->target;
+    int32_t err = target - h;
+    uint8_t done = 0;
+
+    // overshoot is how far past the target we got, in the direction we set out in
+    int32_t past = (target >= vertStartUm) ? h - target : target - h;
+    if (past > vertOvershootUm) vertOvershootUm = past;
+
+    if (step->ctrl != VERT_CTRL_BANG) {
+        CraneSensorData s;
+        SensorTask_GetLatest(&s);
+
+        uint32_t dtMs = (now - vertLastTick) * portTICK_PERIOD_MS;
+        vertLastTick = now;
+
+        int32_t setpoint = target;
+        int32_t ff = 0;
+        uint8_t arrived = 1;
+        if (step->ctrl == VERT_CTRL_PROFILE) {
+            Profile_Step(&vertProfile, dtMs);
+            setpoint = vertProfile.pos;
+            ff = vertProfile.vel;
+            arrived = Profile_Done(&vertProfile);
+        }
 
-    // step 0: raise to first platform
-    case 0:
-    {
-        if (autoStateEntry) {
-            print_str("AUTO: Step0 -> first platform baseline\r\n");
-            autoStateEntry = 0;
+        int32_t speed = Pid_Update(&vertPid, setpoint - h, s.velocityUmS, ff, dtMs);
+        uint16_t pulse = Crane_VerticalPulseForSpeed(speed);
+        if (pulse != vertLoopPulse) {
+            Crane_SetVerticalPulse(pulse);
+            vertLoopPulse = pulse;
         }
 
-        // check if below the first platform (within tolerance)
-        if (h < AUTO_BASE_CM - AUTO_TOL_CM) {
-        	// move up
+        if (!arrived || err > step->tolUm || err < -step->tolUm) {
+            vertInTolSince = 0;
+        } else if (!vertInTolSince) {
+            vertInTolSince = now ? now : 1;
+        } else if (now - vertInTolSince >= pdMS_TO_TICKS(AUTO_SETTLE_MS)) {
+            done = 1;
+        }
+    } else {
+        if (err > step->tolUm) {
             Crane_MoveVerticalDown(); // our function definitions got flipped at the crane_hal level
-        } else if (h > AUTO_BASE_CM + AUTO_TOL_CM) {
-        	// otherwise, move down
+        } else if (err < -step->tolUm) {
             Crane_MoveVerticalUp();
         } else {
-        	// stop if within tolerance
-            Crane_StopVertical();
-            print_str("AUTO: first platform reached, swing RIGHT 600ms\r\n");
-            auto_step = 1;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+            done = 1;
         }
-        break;
     }
 
-    // step 1: rotate platform right for 600ms
-    case 1:
-        if (autoStateEntry) {
-            print_str("AUTO: Step1 -> RIGHT 600ms\r\n");
-            Crane_MovePlatformRight();
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 0;
-        }
-        if (xTaskGetTickCount() - auto_step_start >= pdMS_TO_TICKS(600)) {
-            Crane_StopPlatform();
-            print_str("AUTO: Right 600ms done, now UP +2cm\r\n");
-            auto_step = 2;
-            autoStateEntry = 1;
-        }
-        break;
+    if (done) {
+        verticalStop();
 
-    // step 2 go up 2cm to pick up freight
-    case 2:
-    {
-        float target = AUTO_BASE_CM + 2.0f;
-        if (autoStateEntry) {
-            print_str("AUTO: Step2 -> UP 2cm (to 12cm)\r\n");
-            autoStateEntry = 0;
+        VertStepStats *st = &autoStepStats[idx];
+        st->settleMs = (now - seqStepStart[idx]) * portTICK_PERIOD_MS;
+        st->overshootUm = vertOvershootUm;
+        st->runs++;
+        LOG_INFO(CONTROL, "AUTO: step %u overshoot %ld um", idx, (long)st->overshootUm);
+    }
+    return done;
+}
+
+// ---------------------------------------
+// sequence engine
+// ---------------------------------------
+
+// timed and limit moves, through the same queue as manual mode
+static void seqAxisMove(const SeqStep *step)
+{
+    dir_t dir = Seq_StepDir(step);
+
+    if (step->axis == AXIS_VERTICAL) {
+        if (dir == DIRUP) Crane_MoveVerticalUp(); else Crane_MoveVerticalDown();
+    } else {
+        if (dir == DIRUP) Crane_MovePlatformRight(); else Crane_MovePlatformLeft();
+    }
+}
+
+static void seqAxisStop(const SeqStep *step)
+{
+    if (step->axis == AXIS_VERTICAL) verticalStop(); else Crane_StopPlatform();
+}
+
+// start a step. a height step needs a height to plan from, so without one it doesn't start yet
+// (its timeout is already running). returns 0 if it couldn't start
+static uint8_t seqBegin(const SeqStep *step, uint8_t idx, int32_t h)
+{
+    switch (step->move) {
+    case SEQ_MOVE_HEIGHT:
+        if (h == SENSOR_HEIGHT_INVALID) {
+            return 0;
         }
-        if (h < target - AUTO_TOL_CM) {
-            Crane_MoveVerticalDown();  // again, function name is flipped
-        } else {
-            Crane_StopVertical();
-            print_str("AUTO: 12 cm reached, return to CENTER (LEFT 600ms)\r\n");
-            auto_step = 3;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+        LOG_INFO(CONTROL, "AUTO: step %u -> height %ld um", idx, (long)step->target);
+        verticalBegin(h, step->target);
+        break;
+    case SEQ_MOVE_TIMED:
+        LOG_INFO(CONTROL, "AUTO: step %u -> axis %u for %ld ms", idx, step->axis, (long)step->target);
+        seqAxisMove(step);
+        break;
+    case SEQ_MOVE_LIMIT:
+        LOG_INFO(CONTROL, "AUTO: step %u -> axis %u to limit", idx, step->axis);
+        // already sitting on the switch, the latch finishes the step and no edge follows
+        if (!Crane_LimitLatched((axis_t)step->axis, Seq_StepDir(step))) {
+            seqLimitExpect[step->axis] = Seq_StepDir(step);
         }
+        seqAxisMove(step);
         break;
     }
+    return 1;
+}
 
-    // step 3: retrun to center, rotating left for 600ms
-    case 3:
-        if (autoStateEntry) {
-            print_str("AUTO: Step3 -> LEFT 600ms (back to center)\r\n");
-            Crane_MovePlatformLeft();
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 0;
+// one look at a running step, 1 once it is done (and the axis stopped)
+static uint8_t seqRun(const SeqStep *step, uint8_t idx, int32_t h)
+{
+    uint32_t elapsedMs = (xTaskGetTickCount() - seqStepStart[idx]) * portTICK_PERIOD_MS;
+
+    switch (step->move) {
+    case SEQ_MOVE_HEIGHT:
+        if (h == SENSOR_HEIGHT_INVALID) {
+            // no recent good echo, nothing to steer by. the loop's last pulse would keep the axis
+            // creeping, so it stops until the sensor is back
+            if (vertLoopPulse) {
+                verticalStop();
+            }
+            return 0;
         }
-        if (xTaskGetTickCount() - auto_step_start >= pdMS_TO_TICKS(600)) {
-            Crane_StopPlatform();
-            print_str("AUTO: Centered, now UP +5cm\r\n");
-            auto_step = 4;
-            autoStateEntry = 1;
+        return autoVerticalTo(step, idx, h);
+    case SEQ_MOVE_TIMED:
+        if (elapsedMs < (uint32_t)(step->target < 0 ? -step->target : step->target)) {
+            return 0;
         }
         break;
-
-    // step 4: go up to 14.5cm
-    case 4:
-    {
-        float target = AUTO_BASE_CM + 8.75f;  // 14.5 cm
-        if (autoStateEntry) {
-            print_str("AUTO: Step4 -> UP 5cm (to 15cm)\r\n");
-            autoStateEntry = 0;
-        }
-        if (h < target - AUTO_TOL_CM) {
-            Crane_MoveVerticalDown();
-        } else {
-            Crane_StopVertical();
-            print_str("AUTO: 15 cm reached, LEFT 600ms\r\n");
-            auto_step = 5;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+    case SEQ_MOVE_LIMIT:
+        // the switch's isr already stopped the axis, the latch says it happened
+        if (!Crane_LimitLatched((axis_t)step->axis, Seq_StepDir(step))) {
+            return 0;
         }
         break;
     }
+    seqAxisStop(step);
+    return 1;
+}
 
-    // step 5: rotate left for 600 ms (to hover over top platform)
-    case 5:
-        if (autoStateEntry) {
-            print_str("AUTO: Step5 -> LEFT 600ms\r\n");
-            Crane_MovePlatformLeft();
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 0;
+// may the step start now (start condition, and its axis free)
+static uint8_t seqCanStart(const SeqStep *step, int32_t h)
+{
+    if (seqRunning[step->axis] != SEQ_NONE) {
+        return 0;
+    }
+
+    switch (step->start) {
+    case SEQ_START_AFTER:
+        return seqRunning[AXIS_VERTICAL] == SEQ_NONE && seqRunning[AXIS_PLATFORM] == SEQ_NONE;
+    case SEQ_START_WITH:
+        return 1;
+    case SEQ_START_ABOVE:
+        return h != SENSOR_HEIGHT_INVALID && h >= step->clearUm;
+    case SEQ_START_BELOW:
+        return h != SENSOR_HEIGHT_INVALID && h <= step->clearUm;
+    }
+    return 0;
+}
+
+// when the engine next needs a look without anything waking it: the vertical loop's period,
+// a timed move's end and every step's timeout. a limit step's latch comes with its input
+// event, a step waiting on the sensor gets the sample's wake
+static void seqWakeDeadlines(const SeqTable *table)
+{
+    for (uint8_t axis = AXIS_VERTICAL; axis <= AXIS_PLATFORM; axis++)
+    {
+        uint8_t idx = seqRunning[axis];
+        if (idx == SEQ_NONE) {
+            continue;
         }
-        if (xTaskGetTickCount() - auto_step_start >= pdMS_TO_TICKS(600)) {
-            Crane_StopPlatform();
-            print_str("AUTO: Left 600ms done, DOWN 5cm\r\n");
-            auto_step = 6;
-            autoStateEntry = 1;
+
+        const SeqStep *step = &table->steps[idx];
+        controlWakeAt(seqStepStart[idx] + pdMS_TO_TICKS(step->timeoutMs) + 1);
+        if (step->move == SEQ_MOVE_HEIGHT) {
+            controlWakeAt(passTick + pdMS_TO_TICKS(CONTROL_TASK_PERIOD_MS));
+        } else if (step->move == SEQ_MOVE_TIMED) {
+            controlWakeAt(seqStepStart[idx] + pdMS_TO_TICKS(step->target < 0 ? -step->target : step->target));
         }
-        break;
+    }
+
+    if (seqPending) {
+        controlWakeAt(seqStepStart[seqNext] + pdMS_TO_TICKS(table->steps[seqNext].timeoutMs) + 1);
+    }
+}
+
+static void seqAbort(uint8_t idx)
+{
+    verticalStop();
+    Crane_StopPlatform();
+    seqStats.aborts++;
+    LOG_WARN(CONTROL, "AUTO: step %u failed, sequence aborted", idx);
+    ControlTask_SetMode(MODE_MANUAL);
+}
 
-	// Step 6: Go DOWN 2 cm (from 15 cm to ~13 cm)
-	case 6:
-	{
-		float target = 10.0f;  // 15cm - 2cm = 13cm
-		if (autoStateEntry) {
-			print_str("AUTO: Step6 -> DOWN 2cm (to 13cm)\r\n");
-			autoStateEntry = 0;
-		}
-		if (h > target + AUTO_TOL_CM) {
-			Crane_MoveVerticalUp();
-		} else {
-			Crane_StopVertical();
-			print_str("AUTO: Reached 13cm, return to CENTER (RIGHT 600ms)\r\n");
-			auto_step = 7;
-			auto_step_start = xTaskGetTickCount();
-			autoStateEntry = 1;
-		}
-		break;
-	}
-
-	// step 7: rotate back to center (600ms again)
-	case 7:
-		if (autoStateEntry) {
-			print_str("AUTO: Step7 -> RIGHT 600ms (back to center)\r\n");
-			Crane_MovePlatformRight();
-			auto_step_start = xTaskGetTickCount();
-			autoStateEntry = 0;
-		}
-		if (xTaskGetTickCount() - auto_step_start >= pdMS_TO_TICKS(600)) {
-			Crane_StopPlatform();
-			print_str("AUTO: Centered, DOWN fully to 3cm (PICKUP)\r\n");
-			auto_step = 8;
-			autoStateEntry = 1;
-		}
-		break;
-
-	// step 8: go down fully to 2cm (we get limited by hardware at around 2)
-	case 8:
-	{
-		float target = 2.0f;
-		if (autoStateEntry) {
-			print_str("AUTO: Step8 -> DOWN to 2cm (PICKUP)\r\n");
-			autoStateEntry = 0;
-		}
-		if (h > target + AUTO_TOL_CM) {
-			Crane_MoveVerticalUp();
-		} else {
-			Crane_StopVertical();
-			print_str("AUTO: Reached 2cm, AUTO sequence COMPLETE!\r\n");
-			auto_step = 9;
-			autoStateEntry = 1;
-		}
-		break;
-	}
-
-	//step 9: finish, stop movement and reset states
-	case 9:
-		Crane_StopVertical();
-		Crane_StopPlatform();
-		print_str("AUTO: Full sequence complete. Returning to MANUAL\r\n");
-		ControlTask_SetMode(MODE_MANUAL);
-		auto_step = 0;
-		autoStateEntry = 1;
-		break;
+// the axis and direction a limit event's switch blocks, 0 if no wired line raises it
+static uint8_t limitOfEvent(InputEvent evt, axis_t *axis, dir_t *dir)
+{
+#define CONTROL_LIMIT_OF(label, close, open, ax, d, pair) \
+    if ((d) != DIRSTOP && evt == EVT_##close) { *axis = (ax); *dir = (d); return 1; }
+    INPUT_TABLE(CONTROL_LIMIT_OF, INPUT_IGNORE_EVENT)
+#undef CONTROL_LIMIT_OF
+    return 0;
+}
 
+// a limit step's own hit. its latch may have finished the step (or the whole run) before the
+// debounced event gets here, so it's matched against the axis, not against what is running now
+static uint8_t seqLimitExpected(InputEvent evt)
+{
+    axis_t axis;
+    dir_t dir;
 
-    default:
+    if (!limitOfEvent(evt, &axis, &dir) || seqLimitExpect[axis] != dir) {
+        return 0;
+    }
+    seqLimitExpect[axis] = DIRSTOP;
+    return 1;
+}
+
+// an input event while auto runs. the operator pressing a button or throwing a switch takes
+// over, releases and switches going back to off don't. a limit step's own hit never gets here
+// (seqLimitExpected), any other limit hit stopped its axis under a step that wasn't heading there
+static void autoInputEvent(InputEvent evt)
+{
+    axis_t axis;
+    dir_t dir;
+
+    switch (evt) {
+    case EVT_VERT_BUTTON_PRESSED:
+    case EVT_PLAT_BUTTON_PRESSED:
+    case EVT_VERT_SWITCH_UP:
+    case EVT_VERT_SWITCH_DOWN:
+    case EVT_PLAT_SWITCH_LEFT:
+    case EVT_PLAT_SWITCH_RIGHT:
+        LOG_INFO(CONTROL, "AUTO: Manual input detected! Resetting to MANUAL mode");
+        verticalStop();
+        Crane_StopPlatform();
         auto_step = 0;
-        autoStateEntry = 1;
+        ControlTask_SetMode(MODE_MANUAL);
+        break;
+    case EVT_LIMIT_LEFT_HIT:
+    case EVT_LIMIT_RIGHT_HIT:
+    case EVT_LIMIT_TOP_HIT:
+    case EVT_LIMIT_BOTTOM_HIT:
+        axis = AXIS_VERTICAL;
+        limitOfEvent(evt, &axis, &dir);
+        LOG_WARN(CONTROL, "AUTO: unexpected limit on axis %u", axis);
+        seqAbort(seqRunning[axis] != SEQ_NONE ? seqRunning[axis] : auto_step);
+        break;
+    default:
         break;
     }
 }
 
+// auto mode: run the active table. steps start in order as their start condition allows, so a
+// platform swing can run alongside the end of a vertical move once the load is clear. a finished
+// step hands straight over to the next one in the same pass instead of a control period later.
+// the engine times each step, the run, what the steps add up to (the serial time) and the hand
+// over (DWT cycles from one step done to the next one's first command)
+static void updateAutoMode(void)
+{
+    const SeqTable *table = Seq_Active();
+    uint8_t started;
+
+    // filtered height dead reckoned to now with the commanded speed, so targets are checked
+    // every control period instead of once per ping
+    int32_t h = SensorTask_PredictHeightUm();
+
+    // run what is running, then start what may start, and again while something new started
+    // so it gets its first look (and a finished step its successor) within this same pass
+    do {
+        started = 0;
+        TickType_t now = xTaskGetTickCount();
+
+        for (uint8_t axis = AXIS_VERTICAL; axis <= AXIS_PLATFORM; axis++)
+        {
+            uint8_t idx = seqRunning[axis];
+            if (idx == SEQ_NONE) {
+                continue;
+            }
+
+            const SeqStep *step = &table->steps[idx];
+            if (seqRun(step, idx, h)) {
+                seqStats.stepMs[idx] = (xTaskGetTickCount() - seqStepStart[idx]) * portTICK_PERIOD_MS;
+                seqSerialMs += seqStats.stepMs[idx];
+                seqRunning[axis] = SEQ_NONE;
+                seqTransitionStamp = DWT->CYCCNT;
+            } else if ((now - seqStepStart[idx]) * portTICK_PERIOD_MS > step->timeoutMs) {
+                seqAbort(idx);
+                return;
+            }
+        }
+
+        while (seqNext < table->count)
+        {
+            const SeqStep *step = &table->steps[seqNext];
+
+            if (!seqPending) {
+                if (!seqCanStart(step, h)) {
+                    // nothing left running that could still take the height past the clearance
+                    if (step->start >= SEQ_START_ABOVE && h != SENSOR_HEIGHT_INVALID &&
+                        seqRunning[AXIS_VERTICAL] == SEQ_NONE && seqRunning[AXIS_PLATFORM] == SEQ_NONE) {
+                        LOG_WARN(CONTROL, "AUTO: step %u clearance %ld um not reached", seqNext, (long)step->clearUm);
+                        seqAbort(seqNext);
+                        return;
+                    }
+                    break;
+                }
+                seqStepStart[seqNext] = now;
+                seqPending = 1;
+            }
+
+            if (!seqBegin(step, seqNext, h)) {
+                // height step still waiting on the sensor
+                if ((now - seqStepStart[seqNext]) * portTICK_PERIOD_MS > step->timeoutMs) {
+                    seqAbort(seqNext);
+                    return;
+                }
+                break;
+            }
+
+            if (seqTransitionStamp) {
+                uint32_t cyc = DWT->CYCCNT - seqTransitionStamp;
+                seqStats.transitionLastCyc = cyc;
+                if (cyc > seqStats.transitionMaxCyc) seqStats.transitionMaxCyc = cyc;
+                seqTransitionStamp = 0;
+            }
+
+            seqPending = 0;
+            seqRunning[step->axis] = seqNext;
+            auto_step = seqNext;
+            seqNext++;
+            started = 1;
+        }
+    } while (started);
+
+    if (seqNext < table->count || seqRunning[AXIS_VERTICAL] != SEQ_NONE || seqRunning[AXIS_PLATFORM] != SEQ_NONE) {
+        seqWakeDeadlines(table);
+        return;
+    }
+
+    // all steps done
+    verticalStop();
+    Crane_StopPlatform();
+    seqStats.totalMs = (xTaskGetTickCount() - seqStartTick) * portTICK_PERIOD_MS;
+    seqStats.serialMs = seqSerialMs;
+    seqStats.steps = table->count;
+    seqStats.runs++;
+    seqTransitionStamp = 0;
+    LOG_INFO(CONTROL, "AUTO: Full sequence complete in %lu ms (steps add up to %lu ms). Returning to MANUAL",
+             (unsigned long)seqStats.totalMs, (unsigned long)seqSerialMs);
+    ControlTask_SetMode(MODE_MANUAL);
+    auto_step = 0;
+}
+
 // main control task
 static void ControlTask(void *arg)
 {
     print_str("ControlTask started!\r\n");
-    TickType_t lastWake = xTaskGetTickCount();
+    InputEventMsg msg;
     InputEvent evt;
 
+    ControlTask_ResetWakeStats();
+
     for (;;) {
+        wakeStats.passes++;
+
+        applyRequests();
+
         // process input events entering the control queue
-        while (xQueueReceive(controlQueue, &evt, 0)) {
-            // ignore button/switch events unless we're in manual mode
+        while (xQueueReceive(controlQueue, &msg, 0)) {
+            evt = msg.evt;
+
+            uint32_t lat = DWT->CYCCNT - msg.stamp;
+            inputLatencyLastCyc = lat;
+            if (lat > inputLatencyMaxCyc) inputLatencyMaxCyc = lat;
+
+            if (seqLimitExpected(evt)) {
+                continue;  // a limit step's own hit, the latch already did the work
+            }
+
+            // outside manual mode only reset acts, and in auto an operator override
             if (currentMode != MODE_MANUAL) {
                 // reset button should still work
                 if (evt == EVT_RESET_BUTTON) {
@@ -402,6 +931,8 @@ static void ControlTask(void *arg)
                     platSwitchDir = DIR_NONE;
                     vertCurrentMotion = DIR_NONE;
                     platCurrentMotion = DIR_NONE;
+                } else if (currentMode == MODE_AUTO) {
+                    autoInputEvent(evt);
                 }
                 continue;  // skip other events
             }
@@ -429,19 +960,19 @@ static void ControlTask(void *arg)
 					break;
 
                 case EVT_VERT_BUTTON_PRESSED:
-                    print_str("Control: Vertical BUTTON pressed\r\n");
+                    LOG_DEBUG(CONTROL, "Control: Vertical BUTTON pressed");
                     vertButtonHeld = 1;
                     break;
                 case EVT_VERT_BUTTON_RELEASED:
-                    print_str("Control: Vertical BUTTON released\r\n");
+                    LOG_DEBUG(CONTROL, "Control: Vertical BUTTON released");
                     vertButtonHeld = 0;
                     break;
                 case EVT_PLAT_BUTTON_PRESSED:
-                    print_str("Control: Platform BUTTON pressed\r\n");
+                    LOG_DEBUG(CONTROL, "Control: Platform BUTTON pressed");
                     platButtonHeld = 1;
                     break;
                 case EVT_PLAT_BUTTON_RELEASED:
-                    print_str("Control: Platform BUTTON released\r\n");
+                    LOG_DEBUG(CONTROL, "Control: Platform BUTTON released");
                     platButtonHeld = 0;
                     break;
                 case EVT_VERT_SWITCH_UP:
@@ -463,7 +994,7 @@ static void ControlTask(void *arg)
                     platSwitchDir = DIR_NONE;
                     break;
                 case EVT_RESET_BUTTON:
-                    print_str("Control: RESET\r\n");
+                    LOG_INFO(CONTROL, "Control: RESET");
                     vertSwitchDir = DIR_NONE;
                     vertButtonHeld = 0;
                     platSwitchDir = DIR_NONE;
@@ -478,7 +1009,11 @@ static void ControlTask(void *arg)
             }
         }
 
-        // apply motion based on mode
+        passTick = xTaskGetTickCount();
+        wakeIn = pdMS_TO_TICKS(CONTROL_WATCHDOG_MS);
+        wakeForDeadline = 0;
+
+        // apply motion based on mode, each one asks for the deadlines it has
         if (currentMode == MODE_MANUAL) {
             updateVerticalMotion();
             updatePlatformMotion();
@@ -488,149 +1023,285 @@ static void ControlTask(void *arg)
             updateCalMode();
         }
 
-        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_TASK_PERIOD_MS));
+        // sleep until woken or the deadline. anything that arrived during the pass already left
+        // its bit, so the wait returns at once and nothing is missed between the drain and here
+        TickType_t spent = xTaskGetTickCount() - passTick;
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, CONTROL_WAKE_ALL, &bits, wakeIn > spent ? wakeIn - spent : 0) != pdTRUE) {
+            if (wakeForDeadline) wakeStats.deadline++; else wakeStats.watchdog++;
+            continue;
+        }
+
+        if (bits & CONTROL_WAKE_INPUT) wakeStats.input++;
+        if (bits & CONTROL_WAKE_MODE) wakeStats.mode++;
+        if (bits & CONTROL_WAKE_SENSOR) {
+            CraneSensorData s;
+            SensorTask_GetLatest(&s);
+
+            uint32_t lat = DWT->CYCCNT - s.cyc;
+            wakeStats.sensorLatLastCyc = lat;
+            if (lat > wakeStats.sensorLatMaxCyc) wakeStats.sensorLatMaxCyc = lat;
+            wakeStats.sensor++;
+        }
     }
 }
 
-// control for calibration mode
-void updateCalMode(void)
+// ---------------------------------------
+// calibration mode
+// ---------------------------------------
+
+// finds, for each direction, the pulse that runs at CAL_TARGET_UM_S and the edge of the servo's
+// deadband, and measures the far end of the span. each pass is one timed run at one pulse, the
+// runs alternate direction so one run's travel sets up the next. the speed search brackets the
+// target between the stop pulse and the far end and closes in with false position, the deadband
+// edge is bisected between the widest pulse that stalled and the narrowest that moved (calsearch.h).
+// what was measured becomes the speed model and the presets
+static void calStart(void)
 {
-    CraneSensorData s;
-    if (xQueueReceive(sensorQueue, &s, 0) != pdPASS) {
-        return; // ignore if no valid reading
+    memset(calDirs, 0, sizeof(calDirs));
+    for (uint8_t d = 0; d < 2; d++) {
+        // Crane_SetVerticalPulse sends offsets inside its deadband as a stop, so they can't be
+        // measured and count as stalled from the start
+        calDirs[d].maxStall = CRANE_PULSE_DEADBAND;
+        calDirs[d].minMoving = CAL_SPAN_US;
     }
+    calDir = CAL_DIR_DOWN; // so the first pass rises, the crane usually sits low
+    calMove = CAL_MOVE_POSITION;
+    calReposition = 0;
+    calPasses = 0;
+}
 
-    float h = s.heightCm;
+// pulse for an offset from stop, rising is below it
+static uint16_t calPulse(uint8_t dir, int32_t off)
+{
+    return dir == CAL_DIR_UP ? servo_pwm_stop - off : servo_pwm_stop + off;
+}
 
-    switch (auto_step) {
+static void calBeginDeadband(CalDir *cd)
+{
+    // the first moving pulse's speed doesn't matter to bisection
+    CalSearch_Init(&cd->search, CAL_CREEP_UM_S, 0, CAL_RES_US, 1, cd->maxStall, 0, cd->minMoving, CAL_CREEP_UM_S, 0);
+    cd->phase = cd->search.done ? CAL_PHASE_DONE : CAL_PHASE_DEADBAND;
+    cd->edge = cd->search.lo;
+}
 
-    // step 0: test first speed upwards
-    case 0:
-        if (autoStateEntry) {
-            servo_pwm_backward = 1320; // hardcoded starting point
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 0;
+// one pass measured, move its direction's search on
+static void calRecord(uint8_t dir, int32_t off, int32_t speed)
+{
+    CalDir *cd = &calDirs[dir];
+
+    calPasses++;
+    auto_step = calPasses;
+    LOG_INFO(CONTROL, "CAL: dir %u pulse %u -> %ld um/s", dir, calPulse(dir, off), (long)speed);
+
+    if (speed) {
+        if (cd->nPoints < CAL_MAX_POINTS) {
+            cd->pointOff[cd->nPoints] = off;
+            cd->pointSpeed[cd->nPoints] = speed;
+            cd->nPoints++;
         }
+        if (off < cd->minMoving) cd->minMoving = off;
+    } else if (off > cd->maxStall) {
+        cd->maxStall = off;
+    }
 
-        // check if nelow first target height of 4cm
-        if (h < 4.0f - AUTO_TOL_CM) {
-            Crane_MoveVerticalDown(); // move up (flipped function name)
-        } else if (h > 4.0f + AUTO_TOL_CM) {
-            Crane_MoveVerticalUp(); // move down if above
-        } else {
-        	// stop if we have reached here and calculate results from first test
-            Crane_StopVertical();
-            TickType_t elapsed_ms = xTaskGetTickCount() - auto_step_start;
-            float elapsed_sec = elapsed_ms / 1000.0f;
-            float speed = 4.0f / elapsed_sec;
-            char buf[100];
-            sprintf(buf, "CAL: PWM %d -> Speed: %.2f cm/sec\r\n", servo_pwm_backward, speed);
-            print_str(buf);
-
-            servo_pwm_backward = 1400; // hardcoded secondary value, but ideally this should be selected based off of how far off our speed was
-            auto_step = 1;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+    switch (cd->phase) {
+    case CAL_PHASE_FAR:
+        if (!speed) {
+            // nothing to search between
+            LOG_WARN(CONTROL, "CAL: dir %u doesn't move flat out, calibration aborted", dir);
+            ControlTask_SetMode(MODE_MANUAL);
+            break;
         }
+        if (speed < CAL_TARGET_UM_S) {
+            // flat out is still too slow, that is the best there is
+            LOG_WARN(CONTROL, "CAL: dir %u tops out at %ld um/s", dir, (long)speed);
+            cd->conv = off;
+            cd->convSpeed = speed;
+            calBeginDeadband(cd);
+            break;
+        }
+        // the last calibration's preset is the first guess
+        CalSearch_Init(&cd->search, CAL_TARGET_UM_S, CAL_TOL_UM_S, 1, 0, cd->maxStall, 0, off, speed,
+                       dir == CAL_DIR_UP ? servo_pwm_stop - servo_pwm_vert_backward : servo_pwm_vert_forward - servo_pwm_stop);
+        cd->phase = CAL_PHASE_SPEED;
         break;
-
-    // step 1: test second vertical speed (going up to 8cm)
-    case 1:
-        if (h < 8.0f - AUTO_TOL_CM) {
-            Crane_MoveVerticalDown();
-        } else if (h > 8.0f + AUTO_TOL_CM) {
-            Crane_MoveVerticalUp();
-        } else {
-        	// stop once we reach height within tolerance and calculate results
-            Crane_StopVertical();
-            TickType_t elapsed_ms = xTaskGetTickCount() - auto_step_start;
-            float elapsed_sec = elapsed_ms / 1000.0f;
-            float speed = 4.0f / elapsed_sec;
-            char buf[100];
-            sprintf(buf, "CAL: PWM %d -> Speed: %.2f cm/sec\r\n", servo_pwm_backward, speed);
-            print_str(buf);
-
-            // this is where we would now take the new results and find something either in between or further away from the firts option
-            // it would repeat this loop until we end up close to 2cm/s
-            // however, due to timeconstraints, a hardcoded value was used again
-
-            servo_pwm_backward = 1440; // hardcoded
-            auto_step = 2;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+    case CAL_PHASE_SPEED:
+        if (CalSearch_Feed(&cd->search, off, speed) || cd->search.passes >= CAL_MAX_PASSES) {
+            cd->conv = cd->search.best;
+            cd->convSpeed = cd->search.bestSpeed;
+            calBeginDeadband(cd);
+        }
+        break;
+    case CAL_PHASE_DEADBAND:
+        if (CalSearch_Feed(&cd->search, off, speed) || cd->search.passes >= CAL_MAX_PASSES) {
+            cd->edge = cd->search.lo;
+            cd->phase = CAL_PHASE_DONE;
         }
         break;
+    default:
+        break;
+    }
+}
 
-    // step 2: next test for upwards speed
-    case 2:
-        if (h < 13.0f - AUTO_TOL_CM) {
-            Crane_MoveVerticalDown();
-        } else if (h > 13.0f + AUTO_TOL_CM) {
-            Crane_MoveVerticalUp();
-        } else {
-            Crane_StopVertical();
-            TickType_t elapsed_ms = xTaskGetTickCount() - auto_step_start;
-            float elapsed_sec = elapsed_ms / 1000.0f;
-            float speed = 5.0f / elapsed_sec;
-            char buf[100];
-            sprintf(buf, "CAL: PWM %d (80%%) -> Speed: %.2f cm/sec\r\n", servo_pwm_backward, speed);
-            print_str(buf);
-
-            // this is the comparison that would be made to see if we land within 80% of speed reqs
-            if (speed >= 1.5f && speed <= 1.7f) {
-                print_str("CAL: ✓ 80% Speed OK!\r\n");
-            } else if (speed < 1.5f) {
-                print_str("CAL: ✗ Too slow - increase PWM\r\n");
-            } else {
-                print_str("CAL: ✗ Too fast - decrease PWM\r\n");
-            }
+// a direction's model points from the stop outwards: the deadband edge, then every pulse that
+// moved, dropping any that would make the speed fall (noise) and thinning the closest together
+// down to half the table
+static uint8_t calDirPoints(const CalDir *cd, int32_t *off, int32_t *speed)
+{
+    uint8_t n = 0;
 
-            // instead of logging, we would calculate the final speed
+    off[n] = cd->edge;
+    speed[n] = 0;
+    n++;
 
-            auto_step = 3;
-            auto_step_start = xTaskGetTickCount();
-            autoStateEntry = 1;
+    for (int32_t last = cd->edge; ; ) {
+        // next moving pulse further out
+        int8_t next = -1;
+        for (uint8_t i = 0; i < cd->nPoints; i++) {
+            if (cd->pointOff[i] > last && (next < 0 || cd->pointOff[i] < cd->pointOff[next])) next = i;
         }
-        break;
+        if (next < 0) break;
 
-    // step 3: calculate downward speed
-    case 3:
+        last = cd->pointOff[next];
+        if (cd->pointSpeed[next] > speed[n - 1] && n < CAL_MAX_POINTS) {
+            off[n] = cd->pointOff[next];
+            speed[n] = cd->pointSpeed[next];
+            n++;
+        }
+    }
 
-    	if (autoStateEntry) {
-    	   servo_pwm_forward = 1550; // hardcoded starting point
-    	   autoStateEntry = 0;
-    	}
-        if (h > 2.0f + AUTO_TOL_CM) {
-            Crane_MoveVerticalUp();
-        } else {
-            Crane_StopVertical();
-            TickType_t elapsed_ms = xTaskGetTickCount() - auto_step_start;
-            float elapsed_sec = elapsed_ms / 1000.0f;
-            float speed = 11.0f / elapsed_sec;
-            char buf[100];
-            sprintf(buf, "CAL: Down Speed: %.2f cm/sec\r\n", speed);
-            print_str(buf);
+    while (n > CRANE_SPEED_POINTS_MAX / 2) {
+        // the edge, the target's pulse and the far end stay
+        uint8_t drop = 0;
+        for (uint8_t i = 1; i < n - 1; i++) {
+            if (off[i] != cd->conv && (!drop || off[i] - off[i - 1] < off[drop] - off[drop - 1])) drop = i;
+        }
+        if (!drop) break;
+        for (uint8_t i = drop; i < n - 1; i++) {
+            off[i] = off[i + 1];
+            speed[i] = speed[i + 1];
+        }
+        n--;
+    }
+    return n;
+}
+
+static void calFinish(void)
+{
+    CalDir *up = &calDirs[CAL_DIR_UP];
+    CalDir *down = &calDirs[CAL_DIR_DOWN];
+    speed_point_t table[CRANE_SPEED_POINTS_MAX];
+    int32_t off[CAL_MAX_POINTS], speed[CAL_MAX_POINTS];
+    uint8_t count = 0;
+    uint8_t n;
+
+    // sorted by pulse: rising from the far end in to its deadband edge, then descending out
+    n = calDirPoints(up, off, speed);
+    while (n--) {
+        table[count].pulse = calPulse(CAL_DIR_UP, off[n]);
+        table[count].umPerS = speed[n];
+        count++;
+    }
+    n = calDirPoints(down, off, speed);
+    for (uint8_t i = 0; i < n; i++) {
+        if (calPulse(CAL_DIR_DOWN, off[i]) <= table[count - 1].pulse) {
+            continue; // no deadband either side, both edges are the stop pulse
+        }
+        table[count].pulse = calPulse(CAL_DIR_DOWN, off[i]);
+        table[count].umPerS = -speed[i];
+        count++;
+    }
+
+    if (!Crane_SetSpeedTable(table, count)) {
+        LOG_WARN(CONTROL, "CAL: %u points not usable, speed model kept", count);
+    }
 
-            // we calculate speed here but currently do nothing with it
-            // ideally, would use same procedure outlined in upwards handling to narrow in on the proper pwm value to
-            // achieve the safe speed
+    // vertical presets, the platform's stay as they are
+    servo_pwm_vert_backward = calPulse(CAL_DIR_UP, up->conv);
+    servo_pwm_vert_forward = calPulse(CAL_DIR_DOWN, down->conv);
 
-            auto_step = 4;
-            autoStateEntry = 1;
+    LOG_INFO(CONTROL, "CAL: up %u us -> %ld um/s, deadband to %u us", servo_pwm_vert_backward, (long)up->convSpeed,
+             calPulse(CAL_DIR_UP, up->edge));
+    LOG_INFO(CONTROL, "CAL: down %u us -> %ld um/s, deadband to %u us", servo_pwm_vert_forward, (long)down->convSpeed,
+             calPulse(CAL_DIR_DOWN, down->edge));
+    LOG_INFO(CONTROL, "CAL: done in %u passes, a %u us linear sweep takes %u", calPasses, CAL_SWEEP_US,
+             2 * (CAL_SPAN_US / CAL_SWEEP_US + 1));
+
+    ControlTask_SetMode(MODE_MANUAL);
+}
+
+// control for calibration mode, runs on fresh samples
+static void updateCalMode(void)
+{
+    CraneSensorData s;
+    if (!SensorTask_ReadIfNew(&s, &calSensorSeq)) {
+        return; // ignore if no fresh reading
+    }
+    if (s.status != SENSOR_OK || s.heightFiltUm == SENSOR_HEIGHT_INVALID) {
+        return; // a missing or out of range echo would skew the runs
+    }
+
+    // filtered, a single echo's jitter is a fair part of a run's distance
+    int32_t h = s.heightFiltUm;
+    uint8_t rising = (calDir == CAL_DIR_UP);
+    CalDir *cd = &calDirs[calDir];
+
+    switch (calMove) {
+    case CAL_MOVE_POSITION:
+        // at the preset speed to where a run fits (our function definitions got flipped at the crane_hal level)
+        if (calReposition) {
+            if (rising ? h > CAL_LOW_UM : h < CAL_HIGH_UM) {
+                return;
+            }
+            Crane_StopVertical();
+            calReposition = 0;
+        } else {
+            // next pass, the other direction while it has one
+            if (calDirs[!calDir].phase != CAL_PHASE_DONE) {
+                calDir = !calDir;
+            } else if (cd->phase == CAL_PHASE_DONE) {
+                calFinish();
+                return;
+            }
+            rising = (calDir == CAL_DIR_UP);
+            cd = &calDirs[calDir];
+
+            if (rising ? h > CAL_HIGH_UM - CAL_RUN_UM - CAL_ROOM_UM : h < CAL_LOW_UM + CAL_RUN_UM + CAL_ROOM_UM) {
+                if (rising) Crane_MoveVerticalUp(); else Crane_MoveVerticalDown();
+                calReposition = 1;
+                return;
+            }
         }
+
+        calOff = (cd->phase == CAL_PHASE_FAR) ? CAL_SPAN_US : CalSearch_Next(&cd->search);
+        Crane_SetVerticalPulse(calPulse(calDir, calOff));
+        calRunStart = s.tick;
+        calMove = CAL_MOVE_SPINUP;
         break;
 
-    // complete calibrationand set back to manual
-    case 4:
-        Crane_StopVertical();
-        ControlTask_SetMode(MODE_MANUAL);
-        auto_step = 0;
-        autoStateEntry = 1;
+    case CAL_MOVE_SPINUP:
+        if ((s.tick - calRunStart) * portTICK_PERIOD_MS >= CAL_SPINUP_MS) {
+            calRunStart = s.tick;
+            calRunFromUm = h;
+            calMove = CAL_MOVE_RUN;
+        }
         break;
 
-    default:
-        auto_step = 0;
-        autoStateEntry = 1;
+    case CAL_MOVE_RUN: {
+        uint32_t ms = (s.tick - calRunStart) * portTICK_PERIOD_MS;
+        int32_t dist = rising ? h - calRunFromUm : calRunFromUm - h;
+        int32_t speed = ms ? (int32_t)(((int64_t)dist * 1000) / ms) : 0;
+
+        if (dist < CAL_RUN_UM && ms < CAL_RUN_MAX_MS && !(ms >= CAL_STALL_MS && speed < CAL_CREEP_UM_S) &&
+            (rising ? h < CAL_HIGH_UM : h > CAL_LOW_UM)) {
+            return;
+        }
+
+        Crane_StopVertical();
+        calMove = CAL_MOVE_POSITION;
+        calRecord(calDir, calOff, speed < CAL_CREEP_UM_S ? 0 : speed);
         break;
     }
+    }
 }
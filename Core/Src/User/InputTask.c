@@ -7,161 +7,352 @@
 
 #include "User/InputTask.h"
 #include "User/util.h"
+#include "User/log.h"
 #include "User/ControlTask.h"
+#include "User/crane_hal.h"
+#include "timers.h"
+
+#define SAMPLE_MS				1		// sampler period while any line is unsettled
+#define INPUT_EXTI_PRIORITY		5		// every table line's exti irq, low enough for the FromISR calls
+#define LIMIT_LOG_PERIOD_MS		2000	// a bouncing limit switch logs at most once per period
+
+// every input is on its own exti line (a duplicate pin won't compile, see the isr's switch), both
+// edges interrupt. the lines only wake the sampler, the level comes from one read of each port
+#define INPUT_PORT_INDEX(port)	(((uint32_t)(port) - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE))
+#define INPUT_PIN_NUMBER(pin)	(__builtin_ctz(pin))
+#define INPUT_PORTS				3		// GPIOA..GPIOC, every table pin is on one of these
+
+_Static_assert(INPUT_COUNT <= 16, "input snapshot is 16 bits");
+_Static_assert(INPUT_EXTI_PRIORITY >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, "exti isr calls FreeRTOS");
+#define INPUT_PORT_CHECK(label, close, open, axis, dir, pair) \
+	_Static_assert(INPUT_PORT_INDEX(label##_GPIO_Port) < INPUT_PORTS, #label " is past the ports InputTask_Sample reads");
+INPUT_TABLE(INPUT_PORT_CHECK, INPUT_IGNORE_EVENT)
+#undef INPUT_PORT_CHECK
+
+typedef struct {
+	uint8_t onClose;		// InputEvent when the input goes high
+	uint8_t onOpen;			// InputEvent when it goes low
+	uint8_t limitAxis;		// axis_t a limit switch stops
+	uint8_t limitDir;		// direction it blocks, DIRSTOP if not a limit switch
+	uint8_t pair;			// other side of a three position switch, IN_NONE otherwise
+} InputLine;
+
+static const InputLine inputLines[INPUT_COUNT] = {
+#define INPUT_LINE_ENTRY(label, close, open, axis, dir, pair) \
+	[IN_##label] = { EVT_##close, INPUT_OPEN_EVT_##open, axis, dir, IN_##pair },
+	INPUT_TABLE(INPUT_LINE_ENTRY, INPUT_IGNORE_EVENT)
+#undef INPUT_LINE_ENTRY
+};
+
+#define INPUT_ALL		((uint16_t)((1U << INPUT_COUNT) - 1))
+
+// lines that latch an axis when they close
+#define INPUT_LIMIT_BIT(label, close, open, axis, dir, pair)	| ((dir) != DIRSTOP ? (1U << IN_##label) : 0U)
+#define INPUT_LIMITS	((uint16_t)(0U INPUT_TABLE(INPUT_LIMIT_BIT, INPUT_IGNORE_EVENT)))
+
+// every table pin, as exti line bits
+#define INPUT_PIN_BIT(label, close, open, axis, dir, pair)		| (uint32_t)label##_Pin
+#define INPUT_PINS		(0U INPUT_TABLE(INPUT_PIN_BIT, INPUT_IGNORE_EVENT))
+
+// debounce: every line runs a two bit vertical counter, all of them at once in a handful of word ops.
+// a line's counter only advances while its sample differs from the debounced level and resets the
+// moment they agree, so a line flips after 4 samples in a row on the other level. a limit switch
+// closing flips after 2, its axis is already stopped so this is only how soon the event goes out,
+// and it still needs 4 to open (which lets go of the latch). the sampler is a
+// one shot timer that only runs while some line disagrees, started by the exti edge. reportedMask is
+// the packed snapshot of every debounced level, events only come out of the bits that change in it,
+// so a held input costs nothing after its first event
+static TimerHandle_t sampleTimer;
+static volatile uint16_t reportedMask = 0;		// debounced level per line
+static volatile uint16_t count0 = 0;			// vertical counter, low bit per line
+static volatile uint16_t count1 = 0;			// and high bit
+static volatile uint8_t sampling = 0;			// sampleTimer is armed
+static volatile uint16_t edgePending = 0;		// lines with an edge not yet settled
+static volatile uint32_t lastEdgeStamp[INPUT_COUNT];	// cycle count of the first edge since the line settled
+static volatile uint8_t inputReady = 0;
+
+// edge to event posted latency
+static volatile uint32_t latencyLastCyc = 0;
+static volatile uint32_t latencyMaxCyc = 0;
+static volatile uint32_t eventCount = 0;
+static volatile uint32_t eventsDropped = 0;
+static volatile uint32_t samplerStartFailed = 0;	// edges the sampler couldn't be started for
+
+static void InputTask_SampleTimer(TimerHandle_t timer);
+static void InputTask_InitialScan(void *param1, uint32_t param2);
 
-#define INPUT_TASK_PERIOD_MS	20	// 50Hz
-#define DEBOUNCE_MS				40	// 2 cycles at 50Hz
-#define QUEUE_LENGTH			20
+// ---------------------------------------
+// external functions
+// ---------------------------------------
+void InputTask_Init(void){
+	sampleTimer = xTimerCreate("InSample", pdMS_TO_TICKS(SAMPLE_MS), pdFALSE, NULL, InputTask_SampleTimer);
+
+	// each table pin's exti irq, lines 5..9 and 10..15 share one
+	for (uint32_t m = INPUT_PINS; m; m &= m - 1) {
+		uint8_t line = __builtin_ctz(m);
+		IRQn_Type irq = line <= 4 ? (IRQn_Type)(EXTI0_IRQn + line) : line <= 9 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
 
-QueueHandle_t inputEventQueue = NULL;
+		HAL_NVIC_SetPriority(irq, INPUT_EXTI_PRIORITY, 0);
+		HAL_NVIC_EnableIRQ(irq);
+	}
 
-static TaskHandle_t inputTaskHandle = NULL;
+	// inputs already active at boot have no edge, report them once the timer task runs
+	xTimerPendFunctionCall(InputTask_InitialScan, NULL, 0, 0);
 
-// debounce tracking for button (debounce prevents spamming the button from executing handlers too frequently)
-static uint8_t lastVertBtn = 0;
-static uint8_t lastPlatBtn = 0;
-static TickType_t vertBtnLastChange = 0;
-static TickType_t platBtnLastChange = 0;
+	print_str("Input: EXTI wake, port snapshot + vertical counter debounce\r\n");
+}
 
-// state for reset button
-static uint8_t lastResetBtn = 0;
-static TickType_t resetBtnLastChange = 0;
+void InputTask_GetLatency(uint32_t *lastUs, uint32_t *maxUs, uint32_t *events)
+{
+	uint32_t cycPerUs = SystemCoreClock / 1000000;
 
-static void InputTask(void *arg);
-static void ControlTask_SendEvent(InputEvent evt);
+	*lastUs = latencyLastCyc / cycPerUs;
+	*maxUs = latencyMaxCyc / cycPerUs;
+	*events = eventCount;
+}
 
-// ---------------------------------------
-// external functions
-// ---------------------------------------
-void InputTask_Init(void){
-	// create RTOS task for input task
-	xTaskCreate(
-		InputTask,
-		"InputTask",
-		512,
-		NULL,
-		tskIDLE_PRIORITY + 3,
-		&inputTaskHandle
-	);
+uint32_t InputTask_GetDropped(void)
+{
+	return eventsDropped;
+}
+
+uint16_t InputTask_GetSnapshot(void)
+{
+	return reportedMask;
 }
 
 // ---------------------------------------
-// input task main loop
+// sampling
 // ---------------------------------------
 
-static void InputTask(void *arg){
-	TickType_t lastWake = xTaskGetTickCount();
+// every input's raw level, one bit per line. each port's IDR is read once and the bits are
+// pulled out with constant shifts, no per pin calls or loops
+static inline uint16_t InputTask_Sample(void)
+{
+	const uint32_t idr[INPUT_PORTS] = { GPIOA->IDR, GPIOB->IDR, GPIOC->IDR };
+
+#define INPUT_SAMPLE_BIT(label, close, open, axis, dir, pair) \
+	| (((idr[INPUT_PORT_INDEX(label##_GPIO_Port)] >> INPUT_PIN_NUMBER(label##_Pin)) & 1U) << IN_##label)
+	return (uint16_t)(0U INPUT_TABLE(INPUT_SAMPLE_BIT, INPUT_IGNORE_EVENT));
+#undef INPUT_SAMPLE_BIT
+}
 
-	print_str("Input task started!\r\n");
+// one debounce step over every line, returns the lines whose debounced level flipped.
+// caller keeps the isr out (critical section, or is the isr)
+static uint16_t InputTask_Step(uint16_t sample)
+{
+	uint16_t delta = sample ^ reportedMask;
+	uint16_t toggle;
 
-	for (;;)
-	{
-		// read the gpios
-		uint8_t vertBtn = HAL_GPIO_ReadPin(BUT_VERT_GPIO_Port, BUT_VERT_Pin);
-		uint8_t platBtn = HAL_GPIO_ReadPin(BUT_PLAT_GPIO_Port, BUT_PLAT_Pin);
+	count1 = (count1 ^ count0) & delta;
+	count0 = ~count0 & delta;
+	toggle = delta & ~(count0 | count1);
 
-		uint8_t vertSwUp   = HAL_GPIO_ReadPin(SW_VERT_UP_GPIO_Port, SW_VERT_UP_Pin);
-		uint8_t vertSwDown = HAL_GPIO_ReadPin(SW_VERT_DN_GPIO_Port, SW_VERT_DN_Pin);
+	// limit lines closing, counter at 2
+	uint16_t fast = delta & sample & INPUT_LIMITS & count1 & ~count0;
+	count1 &= ~fast;
+	toggle |= fast;
 
-		uint8_t platSwLeft  = HAL_GPIO_ReadPin(SW_PLAT_L_GPIO_Port, SW_PLAT_L_Pin);
-		uint8_t platSwRight = HAL_GPIO_ReadPin(SW_PLAT_R_GPIO_Port, SW_PLAT_R_Pin);
+	reportedMask ^= toggle;
+	return toggle;
+}
 
-		uint8_t limitSwLeft = HAL_GPIO_ReadPin(LIM_SW_LEFT_GPIO_Port, LIM_SW_LEFT_Pin);
-		uint8_t limitSwRight = HAL_GPIO_ReadPin(LIM_SW_RIGHT_GPIO_Port, LIM_SW_RIGHT_Pin);
+// ---------------------------------------
+// event generation
+// ---------------------------------------
 
-		// top and bottom limit switches omitted since functionality proven with left and right and crane track does not go to top anyway
-//		uint8_t limitSwTop = HAL_GPIO_ReadPin();
-//		uint8_t limitSwBottom = HAL_GPIO_ReadPin();
+static void InputTask_Log(InputEvent evt)
+{
+	switch (evt) {
+	case EVT_LIMIT_LEFT_HIT:
+		LOG_WARN_LIMITED(INPUT, 1, LIMIT_LOG_PERIOD_MS, "LIMIT SWITCH HIT: LEFT");
+		break;
+	case EVT_LIMIT_RIGHT_HIT:
+		LOG_WARN_LIMITED(INPUT, 1, LIMIT_LOG_PERIOD_MS, "LIMIT SWITCH HIT: RIGHT");
+		break;
+	case EVT_VERT_BUTTON_PRESSED:
+		LOG_DEBUG(INPUT, "Vert button pressed");
+		break;
+	case EVT_VERT_BUTTON_RELEASED:
+		LOG_DEBUG(INPUT, "Vert button released");
+		break;
+	case EVT_PLAT_BUTTON_PRESSED:
+		LOG_DEBUG(INPUT, "Plat button pressed");
+		break;
+	case EVT_PLAT_BUTTON_RELEASED:
+		LOG_DEBUG(INPUT, "Plat button released");
+		break;
+	default:
+		break;
+	}
+}
 
-		TickType_t now = xTaskGetTickCount();
+// one event per changed line, nothing for lines that stayed put. timer task context
+static void InputTask_Emit(uint16_t changed, uint16_t levels, const uint32_t *stamps)
+{
+	while (changed)
+	{
+		uint8_t i = __builtin_ctz(changed);
+		uint8_t level = (levels >> i) & 1U;
+		uint8_t evt = level ? inputLines[i].onClose : inputLines[i].onOpen;
+		changed &= changed - 1;
+
+		// a limit switch's latch only lets go on a debounced release
+		if (!level && inputLines[i].limitDir != DIRSTOP) {
+			Crane_LimitClear((axis_t)inputLines[i].limitAxis, (dir_t)inputLines[i].limitDir);
+		}
 
-		// LEFT limit
-		if (limitSwLeft) {
-		    print_str("LIMIT SWITCH HIT: LEFT\r\n");
-		    ControlTask_SendEvent(EVT_LIMIT_LEFT_HIT);
+		// a three position switch is only OFF once neither side is closed
+		if (!level && inputLines[i].pair != IN_NONE && ((levels >> inputLines[i].pair) & 1U)) {
+			evt = EVT_NONE;
 		}
 
-		// RIGHT limit
-		if (limitSwRight) {
-		    print_str("LIMIT SWITCH HIT: RIGHT\r\n");
-		    ControlTask_SendEvent(EVT_LIMIT_RIGHT_HIT);
+		if (evt == EVT_NONE) {
+			continue;
 		}
-//
-//		// TOP limit
-//		if (limitSwTop) {
-//		    print_str("LIMIT SWITCH HIT: TOP\r\n");
-//		    ControlTask_SendEvent(EVT_LIMIT_TOP_HIT);
-//		}
-//
-//		// BOTTOM limit
-//		if (limitSwBottom) {
-//		    print_str("LIMIT SWITCH HIT: BOTTOM\r\n");
-//		    ControlTask_SendEvent(EVT_LIMIT_BOTTOM_HIT);
-//		}
-
-		// handle vertical button
-		if (vertBtn != lastVertBtn && (now - vertBtnLastChange) > pdMS_TO_TICKS(DEBOUNCE_MS)) {
-			print_str("Vert button pressed!\r\n");
-			vertBtnLastChange = now;
-
-			if (vertBtn){
-				ControlTask_SendEvent(EVT_VERT_BUTTON_PRESSED);
-			} else {
-				ControlTask_SendEvent(EVT_VERT_BUTTON_RELEASED);
-			}
-
-			lastVertBtn = vertBtn;
+
+		if (ControlTask_SendEventStamped((InputEvent)evt, stamps[i]) != pdPASS) {
+			eventsDropped++; // control queue full, the transition is lost
+			continue;
 		}
+		InputTask_Log((InputEvent)evt);
 
-		// handle platform button
-		if (platBtn != lastPlatBtn && (now - platBtnLastChange) > pdMS_TO_TICKS(DEBOUNCE_MS)) {
-			print_str("Plat button pressed!\r\n");
-			platBtnLastChange = now;
+		uint32_t lat = DWT->CYCCNT - stamps[i];
+		latencyLastCyc = lat;
+		if (lat > latencyMaxCyc) latencyMaxCyc = lat;
+		eventCount++;
+	}
+}
 
-			if (platBtn){
-				ControlTask_SendEvent(EVT_PLAT_BUTTON_PRESSED);
-			} else {
-				ControlTask_SendEvent(EVT_PLAT_BUTTON_RELEASED);
-			}
+// every exti vector lands here first, whichever table lines are pending get their callback. the
+// hal handler that follows in the vector finds them already cleared
+void InputTask_EXTI_IRQHandler(void)
+{
+	uint32_t pending = EXTI->PR & INPUT_PINS;
 
-			lastPlatBtn = platBtn;
-		}
+	EXTI->PR = pending;
+	for (; pending; pending &= pending - 1) {
+		HAL_GPIO_EXTI_Callback((uint16_t)(1U << __builtin_ctz(pending)));
+	}
+}
 
-		// handle vertical switch
-		if (vertSwUp) {
-			ControlTask_SendEvent(EVT_VERT_SWITCH_UP);
-		} else if (vertSwDown) {
-			ControlTask_SendEvent(EVT_VERT_SWITCH_DOWN);
-		}
+// hal callback for all exti lines
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) // predefined function name by HAL library, recognizes name but uses our implementation
+{
+	uint32_t stamp = DWT->CYCCNT;
+	uint8_t i;
+
+	switch (GPIO_Pin) {
+#define INPUT_PIN_CASE(label, close, open, axis, dir, pair) \
+	case label##_Pin: i = IN_##label; break;
+	INPUT_TABLE(INPUT_PIN_CASE, INPUT_IGNORE_EVENT)
+#undef INPUT_PIN_CASE
+	default:
+		return; // B1 shares exti 15_10
+	}
 
-		// handle platform switch
-		if (platSwLeft) {
-			ControlTask_SendEvent(EVT_PLAT_SWITCH_LEFT);
-		} else if (platSwRight) {
-			ControlTask_SendEvent(EVT_PLAT_SWITCH_RIGHT);
-		}
+	// limit switch closing: stop the axis right here, before debounce or queues.
+	// every bounce that reads high does it again, which is harmless
+	if ((INPUT_LIMITS & (1U << i)) && (InputTask_Sample() & (1U << i))) {
+		Crane_LimitHitFromISR((axis_t)inputLines[i].limitAxis, (dir_t)inputLines[i].limitDir, stamp);
+	}
+
+	if (!inputReady) {
+		return; // edge before the scheduler is up, the initial scan picks up the level
+	}
 
-		// handle reset button
-//		if (resetBtn != lastResetBtn && (now - restBtnLastChange) > pdMS_TO_TICKS(DEBOUNCE_MS)){
-//			resetBtnLastChange = now;
-//
-//			if (resetBtn){
-//				ControlTask_SendEvent(EVT_RESET_BUTTON);
-//			}
-//
-//			lastResetBtn = resetBtn;
-//		}
+	// all exti lines share one priority, so nothing else writes the debounce state while we're here
+	if (!(edgePending & (1U << i))) {
+		edgePending |= (1U << i);
+		lastEdgeStamp[i] = stamp;
+	}
+	if (sampling) {
+		return; // bouncing, or another line is settling, the sampler picks it up
+	}
+
+	// timer command queue full: stay idle so the next edge tries again (the limit stop above
+	// doesn't depend on the sampler)
+	BaseType_t woken = pdFALSE;
 
-		// delay
-		vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(INPUT_TASK_PERIOD_MS));
+	if (xTimerStartFromISR(sampleTimer, &woken) != pdPASS) {
+		samplerStartFailed++;
+		return;
 	}
+
+	// idle means every counter is clear, so this first step can't flip anything
+	InputTask_Step(InputTask_Sample());
+	sampling = 1;
+	portYIELD_FROM_ISR(woken);
 }
 
+// timer task context
+static void InputTask_SampleTimer(TimerHandle_t timer)
+{
+	uint32_t stamps[INPUT_COUNT];
+	uint16_t changed;
+	uint16_t levels;
+	uint8_t again;
+
+	static uint32_t droppedLogged = 0;
+	static uint32_t startFailLogged = 0;
+
+	taskENTER_CRITICAL();
+	changed = InputTask_Step(InputTask_Sample());
+	levels = reportedMask;
+	for (uint16_t m = changed; m; m &= m - 1) {
+		stamps[__builtin_ctz(m)] = lastEdgeStamp[__builtin_ctz(m)];
+	}
+	// a line that settled, flipped or bounced back, waits for a fresh edge again
+	edgePending &= (count0 | count1);
+	again = (count0 | count1) ? 1 : 0;
+	sampling = again;
+	taskEXIT_CRITICAL();
+
+	if (again) {
+		xTimerStart(timer, 0); // not settled, the isr leaves restarting to us
+	}
 
+	InputTask_Emit(changed, levels, stamps);
 
+	if (samplerStartFailed != startFailLogged) {
+		startFailLogged = samplerStartFailed;
+		LOG_WARN(INPUT, "sampler start failed on %lu edges", (unsigned long)startFailLogged);
+	}
 
+	if (eventsDropped != droppedLogged) {
+		droppedLogged = eventsDropped;
+		LOG_WARN(INPUT, "control queue full, %lu input events dropped", (unsigned long)droppedLogged);
+	}
+}
 
+// timer task context, once after the scheduler starts
+static void InputTask_InitialScan(void *param1, uint32_t param2)
+{
+	(void)param1;
+	(void)param2;
 
+	uint32_t stamps[INPUT_COUNT];
+	uint32_t now = DWT->CYCCNT;
+	uint16_t changed;
+	uint16_t levels;
 
+	for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+		stamps[i] = now;
+	}
 
+	taskENTER_CRITICAL();
+	levels = InputTask_Sample();
+	changed = levels ^ reportedMask;
+	reportedMask = levels;
+	count0 = 0;
+	count1 = 0;
+	// already on a limit at boot, latch it like the isr would have
+	for (uint16_t m = levels & INPUT_LIMITS; m; m &= m - 1) {
+		uint8_t i = __builtin_ctz(m);
+		Crane_LimitHitFromISR((axis_t)inputLines[i].limitAxis, (dir_t)inputLines[i].limitDir, now);
+	}
+	inputReady = 1;
+	taskEXIT_CRITICAL();
 
+	InputTask_Emit(changed & INPUT_ALL, levels, stamps);
+}
@@ -1,157 +1,552 @@
 #include "main.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
+#include <string.h>
 
 #include "User/SensorTask.h"
 #include "User/util.h"
 
-#define SENSOR_TASK_PERIOD_MS   10 			// using 100hz period for task
-#define HEIGHT_MIN_CM           1.0f		// clamp lower
-#define HEIGHT_MAX_CM           20.0f		// clamp upper
+// heights are int32 micrometres end to end, nothing in the sensor path touches the fpu
+#define HEIGHT_MIN_UM           10000		// clamp lower (1 cm)
+#define HEIGHT_MAX_UM           200000		// clamp upper (20 cm)
 
-// trigger ultrasonic on pa6
-#define TRIG_PORT   GPIOA
-#define TRIG_PIN    GPIO_PIN_6
+// echo width (us) to distance (um): 343 m/s there and back = 171.5 um per us
+#define PULSE_TO_UM(us)         ((int32_t)(((us) * 343U) >> 1))
+
+// filter: median of the last N good readings feeds an alpha-beta tracker (gains in Q16)
+#define MEDIAN_N                5			// odd, rejects up to 2 outliers in a row
+#define FILTER_ALPHA_Q16        22938		// 0.35, position correction gain
+#define FILTER_BETA_Q16         3277		// 0.05, velocity correction gain
+#define FILTER_MAX_DT_MS        1000		// longer gaps are treated as this (keeps products in 32 bits)
+#define FILTER_MAX_VEL_UM_S     500000		// 50 cm/s, far beyond what the servo can do
+#define FILTER_OUTLIER_UM       10000		// reading this far from the median counts as rejected
+
+// dead reckoning is only trusted this long past the last good echo
+#define PREDICT_MAX_AGE_MS      1000
+
+// ranging rate: fast while the vertical axis moves, keep-alive when it is stopped.
+// pings closer than the minimum gap pick up the previous ping's late echoes (ghosts).
+#define PING_MIN_GAP_MS         25
+#define PING_MOVING_MS          PING_MIN_GAP_MS	// 40 Hz
+#define PING_IDLE_MS            200				// 5 Hz
+
+// tim4 is 16 bits, so it ticks at 10 kHz (prescaler 8399 off the 84 MHz timer clock) to reach the
+// idle period. the trigger pulse is one tick, 100 us, well over the sensor's 10 us minimum
+#define TRIG_TICK_US            100
+#define TRIG_TICKS_PER_MS       (1000 / TRIG_TICK_US)
+#define TRIG_ARR_MAX            0xFFFFU			// 6.5 s
 
 extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
 
-QueueHandle_t sensorQueue = NULL;
 static TaskHandle_t sensorTaskHandle = NULL;
 
-// input capture state machine
-volatile uint32_t ic_start = 0;		// rising edge timestamp
-volatile uint32_t ic_end   = 0;		// falling edge timestamp
-volatile uint8_t  ic_state = 0;   	// 0=rising, 1=falling, 2=complete
+// published samples: double buffered seqlock. the writer fills the slot readers aren't
+// pointed at and then bumps the sequence, so a reader that preempts the writer never
+// sees a half written slot and never has to wait on it. a reader that gets preempted
+// by the writer sees the sequence move and copies again.
+static CraneSensorData sampleSlots[2];
+static volatile uint32_t sampleSeq = 0;		// seq of the newest sample, it lives in sampleSlots[sampleSeq & 1]
 
-// hal callback for tim3 capture (measurement of the echo pulse)
+// task woken on every publish
+static TaskHandle_t sampleListener = NULL;
+static uint32_t sampleListenerBits = 0;
+
+// ranging runs in hardware:
+//   tim4 ch1 (pb6) puts out the trigger pulse (one 100 us tick) every ping period (pwm, arr sets the rate)
+//   tim3 (pb4) is in pwm input mode, ti1 rising resets the counter and latches ccr1,
+//   ti1 falling latches ccr2 = echo width in us. only the cc2 interrupt is enabled.
+
+// hal callback for tim3 capture, one per echo (falling edge on ch2)
 void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) // predefined function name by HAL library, recognizes name but uses our implementation
 {
-	// only process TIM3 ch1 events
     if (htim->Instance == TIM3 &&
-        htim->Channel  == HAL_TIM_ACTIVE_CHANNEL_1)
+        htim->Channel  == HAL_TIM_ACTIVE_CHANNEL_2)
+    {
+        // counter was reset on the rising edge, so the capture is the pulse width
+        uint32_t pulse = HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_2);
+
+        // hand the width to the sensor task and wake it
+        if (sensorTaskHandle != NULL) {
+            BaseType_t woken = pdFALSE;
+            xTaskNotifyFromISR(sensorTaskHandle, pulse, eSetValueWithOverwrite, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+    }
+}
+
+// ranging and health counters
+static volatile uint32_t echoCount = 0;
+static volatile uint32_t echoTimeouts = 0;
+static volatile uint32_t outOfRangeCount = 0;
+static volatile uint32_t latencyLastUs = 0;
+static volatile uint32_t latencyMaxUs = 0;
+static volatile uint32_t latencyHist[SENSOR_LAT_BUCKETS];
+static volatile uint16_t achievedHz = 0;		// samples in the last full second
+static volatile uint8_t periodChanged = 0;		// next dt spans a rate change
+
+// current ping period in ms
+static uint32_t ultrasonic_period_ms(void)
+{
+    return (__HAL_TIM_GET_AUTORELOAD(&htim4) + 1) / TRIG_TICKS_PER_MS;
+}
+
+// change the trigger period without ever putting two pings closer than PING_MIN_GAP_MS
+static void ultrasonic_set_period_ms(uint32_t ms)
+{
+    if (ms < PING_MIN_GAP_MS) ms = PING_MIN_GAP_MS;
+
+    uint32_t arr = ms * TRIG_TICKS_PER_MS - 1;
+    if (arr > TRIG_ARR_MAX) arr = TRIG_ARR_MAX; // the register would just drop the top bits
+    if (arr == __HAL_TIM_GET_AUTORELOAD(&htim4)) {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    if (__HAL_TIM_GET_COUNTER(&htim4) >= arr) {
+        // already further from the last ping than the new period, ping now and restart with it
+        __HAL_TIM_SET_AUTORELOAD(&htim4, arr);
+        htim4.Instance->EGR = TIM_EGR_UG;
+    } else {
+        // bypass the preload so the current period ends at the new length instead of the old one
+        htim4.Instance->CR1 &= ~TIM_CR1_ARPE;
+        __HAL_TIM_SET_AUTORELOAD(&htim4, arr);
+        htim4.Instance->CR1 |= TIM_CR1_ARPE;
+    }
+    periodChanged = 1;
+    taskEXIT_CRITICAL();
+}
+
+// predictor state: height at anchorTick plus speed since then. written by the servo task (speed)
+// and this task (corrections), read by the controller, so always touched inside a critical section
+static int32_t predAnchorUm = SENSOR_HEIGHT_INVALID;
+static TickType_t predAnchorTick = 0;
+static TickType_t predCorrectTick = 0;		// last good echo
+static int32_t predSpeedUmS = 0;
+static volatile int32_t predictErrUm = 0;
+static volatile uint32_t predictErrMaxUm = 0;
+
+// height at tick now, caller holds the critical section
+static int32_t predict_at(TickType_t now)
+{
+    uint32_t ms = (now - predAnchorTick) * portTICK_PERIOD_MS;
+    return predAnchorUm + (int32_t)(((int64_t)predSpeedUmS * ms) / 1000);
+}
+
+void SensorTask_SetVerticalSpeed(int32_t umPerS)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    // bank the distance covered at the old speed before switching
+    taskENTER_CRITICAL();
+    if (predAnchorUm != SENSOR_HEIGHT_INVALID) {
+        predAnchorUm = predict_at(now);
+    }
+    predAnchorTick = now;
+    predSpeedUmS = umPerS;
+    taskEXIT_CRITICAL();
+}
+
+int32_t SensorTask_PredictHeightUm(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    int32_t h;
+
+    taskENTER_CRITICAL();
+    if (predAnchorUm == SENSOR_HEIGHT_INVALID || now - predCorrectTick > pdMS_TO_TICKS(PREDICT_MAX_AGE_MS)) {
+        h = SENSOR_HEIGHT_INVALID;
+    } else {
+        h = predict_at(now);
+    }
+    taskEXIT_CRITICAL();
+
+    return h;
+}
+
+// re-anchor on a good echo, keeping track of how far the model had drifted
+static void predict_correct(int32_t heightUm, TickType_t now)
+{
+    int32_t err = 0;
+
+    taskENTER_CRITICAL();
+    if (predAnchorUm != SENSOR_HEIGHT_INVALID) {
+        err = predict_at(now) - heightUm;
+    }
+    predAnchorUm = heightUm;
+    predAnchorTick = now;
+    predCorrectTick = now;
+    taskEXIT_CRITICAL();
+
+    predictErrUm = err;
+    uint32_t mag = err < 0 ? -err : err;
+    if (mag > predictErrMaxUm) predictErrMaxUm = mag;
+}
+
+void SensorTask_SetVerticalMoving(uint8_t moving)
+{
+    ultrasonic_set_period_ms(moving ? PING_MOVING_MS : PING_IDLE_MS);
+}
+
+
+// wait for the next echo and convert it to um, -1 if it didn't come
+static int32_t ultrasonic_read_um(void)
+{
+    uint32_t pulse;
+
+    // a missing echo shows up as no notification for a couple of ping periods
+    if (xTaskNotifyWait(0, 0xFFFFFFFF, &pulse, pdMS_TO_TICKS(2 * ultrasonic_period_ms())) != pdTRUE)
     {
-    	// check if we are looking for rising
-        if (ic_state == 0)
-        {
-            ic_start = HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_1); // get rising edge timestamp
+        echoTimeouts++;
+        return -1; // timeout or no echo received
+    }
+    echoCount++;
+
+    return PULSE_TO_UM(pulse);
+}
+
+typedef struct {
+    int32_t medianBuf[MEDIAN_N];
+    uint8_t medianCount;		// good readings in the buffer (saturates at MEDIAN_N)
+    uint8_t medianPos;
+    uint8_t started;
+    int32_t height;				// um
+    int32_t velocity;			// um/s
+    uint32_t outliers;			// readings the median didn't pass through
+} HeightFilter;
+
+static HeightFilter filter;
+static volatile uint32_t filterCyclesLast = 0;
+static volatile uint32_t filterCyclesMax = 0;
+
+// median of the buffered readings (insertion sort on a copy, N is tiny)
+static int32_t median_update(HeightFilter *f, int32_t um)
+{
+    int32_t sorted[MEDIAN_N];
 
-            // switch to falling edge for capture at end of pulse
-            __HAL_TIM_SET_CAPTUREPOLARITY(htim,
-                   TIM_CHANNEL_1,
-                   TIM_INPUTCHANNELPOLARITY_FALLING);
+    f->medianBuf[f->medianPos] = um;
+    f->medianPos = (f->medianPos + 1) % MEDIAN_N;
+    if (f->medianCount < MEDIAN_N) f->medianCount++;
 
-            ic_state = 1; // set state to look for falling next
+    for (uint8_t i = 0; i < f->medianCount; i++)
+    {
+        int32_t v = f->medianBuf[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
         }
-        // check if we are looking for fallign edge
-        else if (ic_state == 1)
-        {
-            ic_end = HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_1); // get falling edge ts
+        sorted[j + 1] = v;
+    }
 
-            // switch back to rising for next reading
-            __HAL_TIM_SET_CAPTUREPOLARITY(htim,
-                   TIM_CHANNEL_1,
-                   TIM_INPUTCHANNELPOLARITY_RISING);
+    return sorted[f->medianCount / 2];
+}
 
-            ic_state = 2; // set to complete state
+// alpha-beta step. a reading < 0 means no echo, so only predict
+static void filter_update(HeightFilter *f, int32_t um, uint32_t dtMs)
+{
+    if (dtMs == 0) dtMs = 1;
+    if (dtMs > FILTER_MAX_DT_MS) dtMs = FILTER_MAX_DT_MS;
+
+    // |velocity| <= 500000 and dt <= 1000 keep this inside 32 bits
+    int32_t predicted = f->height + (f->velocity * (int32_t)dtMs) / 1000;
+
+    if (um < 0) {
+        if (f->started) {
+            f->height = predicted;
         }
+        return;
+    }
+
+    int32_t m = median_update(f, um);
+    if (um - m > FILTER_OUTLIER_UM || m - um > FILTER_OUTLIER_UM) {
+        f->outliers++;
+    }
+
+    if (!f->started) {
+        f->height = m;
+        f->velocity = 0;
+        f->started = 1;
+        return;
     }
+
+    int32_t residual = m - predicted;
+
+    // bounded so residual * beta stays inside 32 bits and the divide stays a single sdiv
+    if (residual > 2 * HEIGHT_MAX_UM) residual = 2 * HEIGHT_MAX_UM;
+    if (residual < -2 * HEIGHT_MAX_UM) residual = -2 * HEIGHT_MAX_UM;
+
+    f->height = predicted + (int32_t)(((int64_t)residual * FILTER_ALPHA_Q16) >> 16);
+    f->velocity += (int32_t)(((int64_t)((residual * FILTER_BETA_Q16) / (int32_t)dtMs) * 1000) >> 16);
+
+    if (f->velocity > FILTER_MAX_VEL_UM_S) f->velocity = FILTER_MAX_VEL_UM_S;
+    if (f->velocity < -FILTER_MAX_VEL_UM_S) f->velocity = -FILTER_MAX_VEL_UM_S;
 }
 
-// trigger pulse (10 microseconds)
-static void ultrasonic_trigger(void)
+// ---------------------------------------
+// float reference, only used by SensorTask_Bench to compare against the integer path
+// ---------------------------------------
+
+typedef struct {
+    float medianBuf[MEDIAN_N];
+    uint8_t medianCount;
+    uint8_t medianPos;
+    uint8_t started;
+    float height;
+    float velocity;
+} HeightFilterF;
+
+static void filter_update_float(HeightFilterF *f, uint32_t pulse, float dt)
 {
-	// write gpio to start pulse
-    HAL_GPIO_WritePin(TRIG_PORT, TRIG_PIN, GPIO_PIN_SET);
+    float cm = (pulse * 0.0343f) / 2.0f;
+    float sorted[MEDIAN_N];
 
-    // wait for 10 microseconds using TIM3 counter
-    uint32_t start = __HAL_TIM_GET_COUNTER(&htim3);
-    while ((__HAL_TIM_GET_COUNTER(&htim3) - start) < 10);
+    f->medianBuf[f->medianPos] = cm;
+    f->medianPos = (f->medianPos + 1) % MEDIAN_N;
+    if (f->medianCount < MEDIAN_N) f->medianCount++;
 
-    // write gpio to end pulse
-    HAL_GPIO_WritePin(TRIG_PORT, TRIG_PIN, GPIO_PIN_RESET);
+    for (uint8_t i = 0; i < f->medianCount; i++)
+    {
+        float v = f->medianBuf[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    float m = sorted[f->medianCount / 2];
+
+    if (!f->started) {
+        f->height = m;
+        f->velocity = 0.0f;
+        f->started = 1;
+        return;
+    }
+
+    float predicted = f->height + f->velocity * dt;
+    float residual = m - predicted;
+
+    f->height = predicted + 0.35f * residual;
+    f->velocity += (0.05f / dt) * residual;
 }
 
-// main function for ultrasonic read in cm
-static float ultrasonic_read_cm(void)
+void SensorTask_Bench(uint16_t samples, uint32_t *floatCycles, uint32_t *fixedCycles)
 {
-    ic_state = 0; // set to looking for rising edge first
+    HeightFilterF ff = {0};
+    HeightFilter fi = {0};
+    uint32_t tFloat = 0, tFixed = 0, start;
+    volatile int32_t sink;
+
+    if (samples == 0) samples = 1;
 
-    // reset counter
-    __HAL_TIM_SET_COUNTER(&htim3, 0);
+    // same synthetic echoes for both: ~10 cm with jitter and the odd spike
+    vTaskSuspendAll();
+    for (uint16_t i = 0; i < samples; i++)
+    {
+        uint32_t pulse = 580 + (i * 37) % 60 + ((i % 17) == 0 ? 400 : 0);
+
+        start = DWT->CYCCNT;
+        filter_update_float(&ff, pulse, 0.025f);
+        tFloat += DWT->CYCCNT - start;
 
-    // capture rising edge
-    __HAL_TIM_SET_CAPTUREPOLARITY(&htim3,
-         TIM_CHANNEL_1,
-         TIM_INPUTCHANNELPOLARITY_RISING);
+        start = DWT->CYCCNT;
+        filter_update(&fi, PULSE_TO_UM(pulse), 25);
+        tFixed += DWT->CYCCNT - start;
+    }
+    xTaskResumeAll();
 
-    // start the IC and the interrupt so it will use our callback fn above
-    HAL_TIM_IC_Start_IT(&htim3, TIM_CHANNEL_1);
+    sink = (int32_t)ff.height + fi.height; // keep both results live
+    (void)sink;
 
-    // send ping
-    ultrasonic_trigger();
+    *floatCycles = tFloat / samples;
+    *fixedCycles = tFixed / samples;
+}
 
-    // wait for both edges with timeout (stopped until callback changes ic state to completed)
-    uint32_t timeout = 30000;
-    while (ic_state != 2 && timeout--)
-    {}
+// single writer (SensorTask)
+static void sensor_publish(CraneSensorData *data)
+{
+    uint32_t next = sampleSeq + 1;
 
-    if (ic_state != 2)
-        return -1.0f; // timeout or no echo received
+    data->seq = next;
+    data->cyc = DWT->CYCCNT;
+    sampleSlots[next & 1] = *data;
+    __DMB(); // slot contents before the sequence that points at them
+    sampleSeq = next;
 
-    // calculate pulse width
-    uint32_t pulse =
-        (ic_end >= ic_start)
-          ? (ic_end - ic_start)
-          : (65535 - ic_start + ic_end);
+    if (sampleListener != NULL) {
+        xTaskNotify(sampleListener, sampleListenerBits, eSetBits);
+    }
+}
 
-    // convert pulse width to cm
-    float cm = (pulse * 0.0343f) / 2.0f;
-    return cm;
+void SensorTask_NotifyOnSample(TaskHandle_t task, uint32_t bits)
+{
+    taskENTER_CRITICAL();
+    sampleListener = task;
+    sampleListenerBits = bits;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t SensorTask_GetLatest(CraneSensorData *out)
+{
+    uint32_t seq;
+
+    do {
+        seq = sampleSeq;
+        __DMB();
+        memcpy(out, &sampleSlots[seq & 1], sizeof(*out));
+        __DMB();
+    } while (seq != sampleSeq); // writer published (and may have reused the slot) mid copy
+
+    if (seq == 0) {
+        memset(out, 0, sizeof(*out));
+    }
+    return seq;
+}
+
+uint8_t SensorTask_ReadIfNew(CraneSensorData *out, uint32_t *lastSeq)
+{
+    if (sampleSeq == *lastSeq) {
+        return 0; // cheap check before copying
+    }
+
+    uint32_t seq = SensorTask_GetLatest(out);
+    if (seq == 0 || seq == *lastSeq) {
+        return 0;
+    }
+
+    *lastSeq = seq;
+    return 1;
+}
+
+void SensorTask_GetHealth(SensorHealth *health)
+{
+    health->periodMs = (uint16_t)ultrasonic_period_ms();
+    health->achievedHz = achievedHz;
+    health->echoes = echoCount;
+    health->timeouts = echoTimeouts;
+    health->outOfRange = outOfRangeCount;
+    health->outliers = filter.outliers;
+    health->latencyLastUs = latencyLastUs;
+    health->latencyMaxUs = latencyMaxUs;
+    for (uint8_t i = 0; i < SENSOR_LAT_BUCKETS; i++) {
+        health->latencyHist[i] = latencyHist[i];
+    }
+    health->predictErrUm = predictErrUm;
+    health->predictErrMaxUm = predictErrMaxUm;
+}
+
+// trigger to publish time. tim4 restarts at every trigger and the echo plus filtering is far
+// shorter than a ping period, so its counter is the age of the sample (to a tick)
+static void latency_record(void)
+{
+    uint32_t us = __HAL_TIM_GET_COUNTER(&htim4) * TRIG_TICK_US;
+    uint8_t bucket = 0;
+
+    while (bucket < SENSOR_LAT_BUCKETS - 1 && us >= (1000U << bucket)) {
+        bucket++;
+    }
+    latencyHist[bucket]++;
+    latencyLastUs = us;
+    if (us > latencyMaxUs) latencyMaxUs = us;
+}
+
+void SensorTask_GetFilterCycles(uint32_t *last, uint32_t *max)
+{
+    *last = filterCyclesLast;
+    *max = filterCyclesMax;
 }
 
 // main sensor task
 static void SensorTask(void *arg)
 {
     CraneSensorData data;
+    TickType_t lastTick = xTaskGetTickCount();
+    TickType_t rateWindowStart = lastTick;
+    uint16_t rateWindowCount = 0;
 
-    print_str("SensorTask started (TIM3 IC, PB4 ECHO) - 1ms updates\r\n");
+    print_str("SensorTask started (TIM4 trigger PB6, TIM3 PWM input PB4 ECHO)\r\n");
 
     while (1)
     {
-    	// get sensor reading of distance to ground in cm
-        float d = ultrasonic_read_cm();
-
-        // clamp distance
-        if (d < HEIGHT_MIN_CM) d = HEIGHT_MIN_CM;
-        if (d > HEIGHT_MAX_CM) d = HEIGHT_MAX_CM;
+    	// get sensor reading of distance to ground in um
+        int32_t d = ultrasonic_read_um();
+        TickType_t now = xTaskGetTickCount();
+
+        // pings are hardware timed, so dt is a whole number of ping periods (ticks only pick which).
+        // across a rate change that doesn't hold, use the tick difference instead
+        uint32_t period = ultrasonic_period_ms();
+        uint32_t elapsed = (now - lastTick) * portTICK_PERIOD_MS;
+        uint32_t pings = (elapsed + period / 2) / period;
+        uint32_t dtMs = (periodChanged || pings == 0) ? elapsed : pings * period;
+        periodChanged = 0;
+        lastTick = now;
+
+        // achieved sample rate over one second windows
+        rateWindowCount++;
+        if (now - rateWindowStart >= pdMS_TO_TICKS(1000)) {
+            achievedHz = rateWindowCount;
+            rateWindowCount = 0;
+            rateWindowStart = now;
+        }
 
-        // set crane data height in cm and normalized height (0-1)
-        data.heightCm = d;
-        data.heightNorm =
-            (d - HEIGHT_MIN_CM) /
-            (HEIGHT_MAX_CM - HEIGHT_MIN_CM);
+        // only in range echoes go into the filter, the rest are published as what they are
+        if (d < 0) {
+            data.status = SENSOR_NO_ECHO;
+        } else if (d < HEIGHT_MIN_UM || d > HEIGHT_MAX_UM) {
+            data.status = SENSOR_OUT_OF_RANGE;
+            outOfRangeCount++;
+        } else {
+            data.status = SENSOR_OK;
+        }
 
-        // put reading into sensor queue for other tasks to consume
-        xQueueOverwrite(sensorQueue, &data);
+        uint32_t start = DWT->CYCCNT;
+        filter_update(&filter, data.status == SENSOR_OK ? d : -1, dtMs);
+        filterCyclesLast = DWT->CYCCNT - start;
+        if (filterCyclesLast > filterCyclesMax) filterCyclesMax = filterCyclesLast;
+
+        if (d < 0) {
+            data.heightUm = SENSOR_HEIGHT_INVALID;
+            data.heightNorm = 0;
+        } else {
+            // normalized height saturates, the raw one stays as measured
+            int32_t c = d;
+            if (c < HEIGHT_MIN_UM) c = HEIGHT_MIN_UM;
+            if (c > HEIGHT_MAX_UM) c = HEIGHT_MAX_UM;
+
+            data.heightUm = d;
+            data.heightNorm = (uint16_t)(((uint32_t)(c - HEIGHT_MIN_UM) * SENSOR_NORM_ONE) /
+                                         (HEIGHT_MAX_UM - HEIGHT_MIN_UM));
+        }
+        data.heightFiltUm = filter.started ? filter.height : SENSOR_HEIGHT_INVALID;
+        if (data.status == SENSOR_OK) {
+            predict_correct(filter.height, now);
+        }
+        data.velocityUmS = filter.velocity;
+        data.tick = now;
 
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS)); // delay
+        // publish for the other tasks to read
+        sensor_publish(&data); // paced by the trigger timer, no delay needed
+        if (d >= 0) {
+            latency_record();
+        }
     }
 }
 
 // initialization function
 void SensorTask_Init(void)
 {
-    // create queue for sensor data to be pushed to
-    sensorQueue = xQueueCreate(1, sizeof(CraneSensorData));
-
-    // enable interrupts for input capture
-    HAL_TIM_IC_Start_IT(&htim3, TIM_CHANNEL_1);
-
     xTaskCreate(SensorTask,
 		"SensorTask",
 		512,
 		NULL,
 		tskIDLE_PRIORITY + 1,
 		&sensorTaskHandle);
+
+    // pwm input capture, only the falling edge (ch2) interrupts
+    HAL_TIM_IC_Start(&htim3, TIM_CHANNEL_1);
+    HAL_TIM_IC_Start_IT(&htim3, TIM_CHANNEL_2);
+
+    // free running trigger pulses, crane starts out stopped
+    ultrasonic_set_period_ms(PING_IDLE_MS);
+    HAL_TIM_PWM_Start(&htim4, TIM_CHANNEL_1);
 }
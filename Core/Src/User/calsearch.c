@@ -0,0 +1,95 @@
+/*
+ * calsearch.c
+ *
+ *  Created on: Dec 11, 2025
+ *      Author: ryang
+ */
+
+#include "User/calsearch.h"
+
+void CalSearch_Init(CalSearch *cs, int32_t target, int32_t tol, int32_t res, uint8_t bisect,
+		int32_t lo, int32_t loSpeed, int32_t hi, int32_t hiSpeed, int32_t guess)
+{
+	cs->target = target;
+	cs->tol = tol;
+	cs->res = res > 0 ? res : 1;
+	cs->bisect = bisect;
+	cs->lo = lo;
+	cs->loSpeed = loSpeed;
+	cs->hi = hi;
+	cs->hiSpeed = hiSpeed;
+	cs->loF = loSpeed - target;
+	cs->hiF = hiSpeed - target;
+	cs->side = 0;
+	cs->guess = guess;
+	cs->passes = 0;
+	cs->done = (hi - lo <= cs->res);
+
+	// until something closer is measured, the end nearer the target
+	if (-cs->loF < cs->hiF) {
+		cs->best = lo;
+		cs->bestSpeed = loSpeed;
+	} else {
+		cs->best = hi;
+		cs->bestSpeed = hiSpeed;
+	}
+}
+
+int32_t CalSearch_Next(CalSearch *cs)
+{
+	int32_t off;
+
+	if (cs->guess > cs->lo && cs->guess < cs->hi) {
+		off = cs->guess;
+	} else if (cs->bisect || cs->hiF <= cs->loF) {
+		off = cs->lo + (cs->hi - cs->lo) / 2;
+	} else {
+		// where the line through both ends crosses the target
+		off = cs->lo + (int32_t)(((int64_t)(cs->hi - cs->lo) * -cs->loF) / (cs->hiF - cs->loF));
+	}
+	cs->guess = 0;
+
+	// always strictly inside, or the bracket wouldn't shrink
+	if (off <= cs->lo) off = cs->lo + 1;
+	if (off >= cs->hi) off = cs->hi - 1;
+	return off;
+}
+
+uint8_t CalSearch_Feed(CalSearch *cs, int32_t off, int32_t speed)
+{
+	int32_t f = speed - cs->target;
+
+	cs->passes++;
+
+	if ((f < 0 ? -f : f) < (cs->bestSpeed - cs->target < 0 ? cs->target - cs->bestSpeed : cs->bestSpeed - cs->target)) {
+		cs->best = off;
+		cs->bestSpeed = speed;
+	}
+
+	if (cs->tol && (f < 0 ? -f : f) <= cs->tol) {
+		cs->best = off;
+		cs->bestSpeed = speed;
+		cs->done = 1;
+		return 1;
+	}
+
+	// a speed outside the bracket's is noise, it still narrows the bracket on its side
+	if (f < 0) {
+		cs->lo = off;
+		cs->loSpeed = speed;
+		cs->loF = f;
+		if (cs->side == -1) cs->hiF /= 2;	// lo moved twice running, pull the line towards hi
+		cs->side = -1;
+	} else {
+		cs->hi = off;
+		cs->hiSpeed = speed;
+		cs->hiF = f;
+		if (cs->side == 1) cs->loF /= 2;
+		cs->side = 1;
+	}
+
+	if (cs->hi - cs->lo <= cs->res) {
+		cs->done = 1;
+	}
+	return cs->done;
+}
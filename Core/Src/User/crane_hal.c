@@ -1,5 +1,7 @@
 #include "User/crane_hal.h"
 #include "User/util.h"
+#include "User/log.h"
+#include "User/SensorTask.h"
 #include "main.h"
 #include "FreeRTOS.h"
 #include "queue.h"
@@ -9,40 +11,206 @@ QueueHandle_t servo_Queue = NULL;
 static dir_t last_dir_vertical = DIRSTOP;
 static dir_t last_dir_platform = DIRSTOP;
 
-// global PWM values (adjustable via calibration mode) - these are pretty stable, hardcoded values even if cal isn't performed
+// directions blocked by a limit switch, bit (1 << dir) per axis
+static volatile uint8_t limitLatched[2] = {0, 0};
+static volatile uint32_t limitStopLastCyc = 0;
+static volatile uint32_t limitStopMaxCyc = 0;
+static volatile uint32_t limitStopCount = 0;
+
+// global PWM values - these are pretty stable, hardcoded values
 uint16_t servo_pwm_forward = 1570;
 uint16_t servo_pwm_backward = 1440;
 uint16_t servo_pwm_stop = 1500;
 
+// the vertical axis' own presets, calibration mode replaces them (the platform keeps the ones above)
+uint16_t servo_pwm_vert_forward = 1570;
+uint16_t servo_pwm_vert_backward = 1440;
+
+// sorted by pulse. measured on the rig once, cal mode refines the points it drives at
+static speed_point_t speedPoints[CRANE_SPEED_POINTS_MAX] = {
+    {1320,  40000},
+    {1400,  24000},
+    {1440,  16000},
+    {1485,      0},	// servo deadband
+    {1515,      0},
+    {1550, -12000},
+    {1570, -16000},
+    {1680, -40000},
+};
+static uint8_t speedPointCount = 8;
+
+int32_t Crane_VerticalSpeedUmS(uint16_t pulse)
+{
+    // flat outside the calibrated span
+    if (pulse <= speedPoints[0].pulse) return speedPoints[0].umPerS;
+    if (pulse >= speedPoints[speedPointCount - 1].pulse) return speedPoints[speedPointCount - 1].umPerS;
+
+    uint8_t i = 1;
+    while (speedPoints[i].pulse < pulse) i++;
+
+    const speed_point_t *a = &speedPoints[i - 1];
+    const speed_point_t *b = &speedPoints[i];
+    return a->umPerS + ((b->umPerS - a->umPerS) * (int32_t)(pulse - a->pulse)) / (int32_t)(b->pulse - a->pulse);
+}
+
+uint16_t Crane_VerticalPulseForSpeed(int32_t umPerS)
+{
+    if (umPerS == 0) return servo_pwm_stop;
+
+    // speed falls as the pulse rises, flat across the deadband
+    if (umPerS >= speedPoints[0].umPerS) return speedPoints[0].pulse;
+    if (umPerS <= speedPoints[speedPointCount - 1].umPerS) return speedPoints[speedPointCount - 1].pulse;
+
+    uint8_t i = 1;
+    while (speedPoints[i].umPerS > umPerS) i++;
+
+    // a is above the speed, b at or below it, so the span is never zero
+    const speed_point_t *a = &speedPoints[i - 1];
+    const speed_point_t *b = &speedPoints[i];
+    return a->pulse + ((int32_t)(b->pulse - a->pulse) * (a->umPerS - umPerS)) / (a->umPerS - b->umPerS);
+}
+
+void Crane_SetSpeedPoint(uint16_t pulse, int32_t umPerS)
+{
+    uint8_t i;
+
+    taskENTER_CRITICAL();
+    for (i = 0; i < speedPointCount && speedPoints[i].pulse < pulse; i++);
+
+    if (i < speedPointCount && speedPoints[i].pulse == pulse) {
+        speedPoints[i].umPerS = umPerS;
+    } else if (speedPointCount < CRANE_SPEED_POINTS_MAX) {
+        // open a slot at i
+        for (uint8_t j = speedPointCount; j > i; j--) speedPoints[j] = speedPoints[j - 1];
+        speedPoints[i].pulse = pulse;
+        speedPoints[i].umPerS = umPerS;
+        speedPointCount++;
+    } else {
+        // full, the closer neighbour takes the new point (order is kept either way)
+        if (i == speedPointCount || (i > 0 && pulse - speedPoints[i - 1].pulse < speedPoints[i].pulse - pulse)) i--;
+        speedPoints[i].pulse = pulse;
+        speedPoints[i].umPerS = umPerS;
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint8_t Crane_SetSpeedTable(const speed_point_t *points, uint8_t count)
+{
+    if (count < 2 || count > CRANE_SPEED_POINTS_MAX) {
+        return 0;
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        if (points[i].pulse <= points[i - 1].pulse || points[i].umPerS > points[i - 1].umPerS) {
+            return 0;
+        }
+    }
+
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < count; i++) speedPoints[i] = points[i];
+    speedPointCount = count;
+    taskEXIT_CRITICAL();
+    return 1;
+}
+
+
+static volatile uint32_t *axis_ccr(axis_t axis) {
+    return (axis == AXIS_VERTICAL) ? &TIM1->CCR1 : &TIM1->CCR2;
+}
+
+// start moving unless a limit switch has that direction latched. checked and written with the
+// limit isr masked, so it can't stop the axis between our check and our write
+static uint8_t start_axis(axis_t axis, dir_t dir, uint16_t pulse) {
+    uint8_t ok;
+
+    taskENTER_CRITICAL();
+    ok = !(limitLatched[axis] & (1U << dir));
+    if (ok) {
+        *axis_ccr(axis) = pulse;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!ok) {
+        LOG_WARN(SERVO, "Crane: move refused, limit switch latched");
+    }
+    return ok;
+}
 
-static void start_servo_fwd(TIM_HandleTypeDef *servo) {
+static uint8_t start_servo_fwd(TIM_HandleTypeDef *servo) {
     // if
 	if (servo == &htim1) {
-        __HAL_TIM_SET_COMPARE(servo, TIM_CHANNEL_1, servo_pwm_forward);  // using pwm speed variable
-        print_str("Crane: MOVING VERTICAL UP\r\n");
+        if (start_axis(AXIS_VERTICAL, DIRUP, servo_pwm_vert_forward)) {  // using pwm speed variable
+            LOG_DEBUG(SERVO, "Crane: MOVING VERTICAL UP");
+            return 1;
+        }
     } else { // Platform CH2
-        __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, servo_pwm_forward);
-        print_str("Crane: ROTATING RIGHT\r\n");
+        if (start_axis(AXIS_PLATFORM, DIRUP, servo_pwm_forward)) {
+            LOG_DEBUG(SERVO, "Crane: ROTATING RIGHT");
+            return 1;
+        }
     }
+    return 0;
 }
 
-static void start_servo_bck(TIM_HandleTypeDef *servo) {
+static uint8_t start_servo_bck(TIM_HandleTypeDef *servo) {
     if (servo == &htim1) { // Vertical CH1
-        __HAL_TIM_SET_COMPARE(servo, TIM_CHANNEL_1, servo_pwm_backward);
-        print_str("Crane: MOVING VERTICAL DOWN\r\n");
+        if (start_axis(AXIS_VERTICAL, DIRDOWN, servo_pwm_vert_backward)) {
+            LOG_DEBUG(SERVO, "Crane: MOVING VERTICAL DOWN");
+            return 1;
+        }
     } else { // Platform CH2
-        __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, servo_pwm_backward);
-        print_str("Crane: ROTATING LEFT\r\n");
+        if (start_axis(AXIS_PLATFORM, DIRDOWN, servo_pwm_backward)) {
+            LOG_DEBUG(SERVO, "Crane: ROTATING LEFT");
+            return 1;
+        }
     }
+    return 0;
+}
+
+void Crane_LimitHitFromISR(axis_t axis, dir_t dir, uint32_t stamp) {
+    // stop first, everything else can wait
+    *axis_ccr(axis) = servo_pwm_stop;
+    uint32_t lat = DWT->CYCCNT - stamp;
+    uint8_t first = !(limitLatched[axis] & (1U << dir));
+
+    limitLatched[axis] |= (1U << dir);
+    limitStopLastCyc = lat;
+    if (lat > limitStopMaxCyc) limitStopMaxCyc = lat;
+    limitStopCount++;
+
+    // then the servo task, through the same stop as Crane_StopVertical/Platform: its direction
+    // goes back to stop (so the move away isn't taken for a reversal) and the sensor's predictor
+    // and ping rate see the axis stopped. once per hit, the bounces find the latch already set
+    if (first && servo_Queue) {
+        servo_cmd_t cmd = {axis == AXIS_VERTICAL ? &htim1 : NULL, DIRSTOP};
+        BaseType_t woken = pdFALSE;
+        xQueueSendFromISR(servo_Queue, &cmd, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+void Crane_LimitClear(axis_t axis, dir_t dir) {
+    taskENTER_CRITICAL();
+    limitLatched[axis] &= ~(1U << dir);
+    taskEXIT_CRITICAL();
+}
+
+uint8_t Crane_LimitLatched(axis_t axis, dir_t dir) {
+    return (limitLatched[axis] & (1U << dir)) ? 1 : 0;
+}
+
+void Crane_GetLimitStopLatency(uint32_t *lastCyc, uint32_t *maxCyc, uint32_t *count) {
+    *lastCyc = limitStopLastCyc;
+    *maxCyc = limitStopMaxCyc;
+    *count = limitStopCount;
 }
 
 static void stop_servo(TIM_HandleTypeDef *servo){
     if (servo == &htim1) {  // Vertical CH1
         __HAL_TIM_SET_COMPARE(servo, TIM_CHANNEL_1, servo_pwm_stop);
-        print_str("Crane: STOP VERTICAL\r\n");
+        LOG_DEBUG(SERVO, "Crane: STOP VERTICAL");
     } else {  // Platform CH2
         __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, servo_pwm_stop);
-        print_str("Crane: STOP PLATFORM\r\n");
+        LOG_DEBUG(SERVO, "Crane: STOP PLATFORM");
     }
 }
 
@@ -62,6 +230,22 @@ void Crane_StopVertical(void) {
     if (servo_Queue) xQueueSend(servo_Queue, &cmd, 0);
 }
 
+void Crane_SetVerticalPulse(uint16_t pulse) {
+    uint16_t lo = speedPoints[0].pulse;
+    uint16_t hi = speedPoints[speedPointCount - 1].pulse;
+    dir_t dir = DIRSTOP;
+
+    if (pulse < lo) pulse = lo;
+    if (pulse > hi) pulse = hi;
+
+    // same naming as the preset moves: above stop is "up" (forward), below is "down"
+    if (pulse > servo_pwm_stop + CRANE_PULSE_DEADBAND) dir = DIRUP;
+    else if (pulse + CRANE_PULSE_DEADBAND < servo_pwm_stop) dir = DIRDOWN;
+
+    servo_cmd_t cmd = {&htim1, dir, dir == DIRSTOP ? servo_pwm_stop : pulse};
+    if (servo_Queue) xQueueSend(servo_Queue, &cmd, 0);
+}
+
 void Crane_MovePlatformRight(void) {
     servo_cmd_t cmd = {NULL, DIRUP};
     if (servo_Queue) xQueueSend(servo_Queue, &cmd, 0);
@@ -85,16 +269,39 @@ static void servo_controller_task(void) {
 
     // create queue for servo commands
     servo_Queue = xQueueCreate(10, sizeof(servo_cmd_t));
-    print_str("Servo controller started\r\n");
+    LOG_INFO(SERVO, "Servo controller started");
 
     while (xQueueReceive(servo_Queue, &current_cmd, portMAX_DELAY) == pdPASS) {
         // check if current command has htim assigned (this is what we have to denote ch1 for the timer)
+        // a limit switch's isr stopped the axis behind our back. its stop notice normally says so,
+        // this covers a full queue having dropped it
+        if (last_dir_vertical != DIRSTOP && Crane_LimitLatched(AXIS_VERTICAL, last_dir_vertical)) {
+            last_dir_vertical = DIRSTOP;
+        }
+        if (last_dir_platform != DIRSTOP && Crane_LimitLatched(AXIS_PLATFORM, last_dir_platform)) {
+            last_dir_platform = DIRSTOP;
+        }
+
         if (current_cmd.htim == &htim1) {
+            // closed loop pulse: written as is, no stop on reversal since the loop ramps
+            // through the deadband on its own. only direction changes are logged
+            if (current_cmd.pulse) {
+                dir_t dir = current_cmd.servodir;
+                if (dir == DIRSTOP) {
+                    __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, servo_pwm_stop);
+                } else if (!start_axis(AXIS_VERTICAL, dir, current_cmd.pulse)) {
+                    dir = DIRSTOP;
+                }
+                if (dir != last_dir_vertical) {
+                    LOG_DEBUG(SERVO, "Crane: vertical loop pulse %u", current_cmd.pulse);
+                }
+                last_dir_vertical = dir;
         	// if previously stopped, start the next movement right away
-            if (last_dir_vertical == DIRSTOP) {
-                if (current_cmd.servodir == DIRUP) start_servo_fwd(&htim1);
-                else if (current_cmd.servodir == DIRDOWN) start_servo_bck(&htim1);
-                last_dir_vertical = current_cmd.servodir;
+            } else if (last_dir_vertical == DIRSTOP) {
+                uint8_t started = 0;
+                if (current_cmd.servodir == DIRUP) started = start_servo_fwd(&htim1);
+                else if (current_cmd.servodir == DIRDOWN) started = start_servo_bck(&htim1);
+                last_dir_vertical = started ? current_cmd.servodir : DIRSTOP; // a latched limit refuses the move
             // if changing direction, do a hard stop first
             } else if ((last_dir_vertical == DIRUP && current_cmd.servodir == DIRDOWN) ||
                        (last_dir_vertical == DIRDOWN && current_cmd.servodir == DIRUP)) {
@@ -105,14 +312,19 @@ static void servo_controller_task(void) {
                 stop_servo(&htim1);
                 last_dir_vertical = DIRSTOP;
             }
+
+            // ranging rate follows vertical motion (no-op if unchanged), the height predictor the commanded speed
+            SensorTask_SetVerticalMoving(last_dir_vertical != DIRSTOP);
+            SensorTask_SetVerticalSpeed(Crane_VerticalSpeedUmS(__HAL_TIM_GET_COMPARE(&htim1, TIM_CHANNEL_1)));
         }
         // if null, it is ch2 for the timer (which we have rigged up to the platform servo)
         else {
         	// some conceptual handling as above for ch1, but for platform vars and using NULL isntead of htim1 in servo fns
             if (last_dir_platform == DIRSTOP) {
-                if (current_cmd.servodir == DIRUP) start_servo_fwd(NULL);
-                else if (current_cmd.servodir == DIRDOWN) start_servo_bck(NULL);
-                last_dir_platform = current_cmd.servodir;
+                uint8_t started = 0;
+                if (current_cmd.servodir == DIRUP) started = start_servo_fwd(NULL);
+                else if (current_cmd.servodir == DIRDOWN) started = start_servo_bck(NULL);
+                last_dir_platform = started ? current_cmd.servodir : DIRSTOP;
             } else if ((last_dir_platform == DIRUP && current_cmd.servodir == DIRDOWN) ||
                        (last_dir_platform == DIRDOWN && current_cmd.servodir == DIRUP)) {
                 stop_servo(NULL);
@@ -0,0 +1,82 @@
+/*
+ * link.c
+ *
+ *  Created on: Dec 3, 2025
+ *      Author: ryang
+ */
+
+#include <string.h>
+
+#include "User/link.h"
+#include "User/util.h"
+
+// type byte + payload + crc, plus cobs overhead and both delimiters
+#define LINK_RAW_MAX		(1 + LINK_MAX_PAYLOAD + 2)
+#define LINK_ENCODED_MAX	(LINK_RAW_MAX + (LINK_RAW_MAX / 254) + 1 + 2)
+
+// nibble table for crc16-ccitt, keeps flash use small without bit-by-bit looping
+static const uint16_t crcNibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t link_crc16(const uint8_t *data, uint16_t len, uint16_t crc)
+{
+	while (len--) {
+		uint8_t b = *data++;
+		crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (b >> 4)];
+		crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (b & 0x0F)];
+	}
+	return crc;
+}
+
+// consistent overhead byte stuffing, removes every 0x00 so it can be used as the delimiter
+static uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+	uint16_t code_idx = 0;	// where the current block's length code goes
+	uint16_t out_idx = 1;
+	uint8_t code = 1;
+
+	for (uint16_t i = 0; i < len; i++) {
+		if (in[i] == 0) {
+			out[code_idx] = code;
+			code_idx = out_idx++;
+			code = 1;
+		} else {
+			out[out_idx++] = in[i];
+			code++;
+			if (code == 0xFF) {
+				out[code_idx] = code;
+				code_idx = out_idx++;
+				code = 1;
+			}
+		}
+	}
+	out[code_idx] = code;
+
+	return out_idx;
+}
+
+uint8_t link_send_frame(uint8_t type, const void *payload, uint16_t len)
+{
+	uint8_t raw[LINK_RAW_MAX];
+	uint8_t enc[LINK_ENCODED_MAX];
+
+	if (len > LINK_MAX_PAYLOAD) {
+		return 0;
+	}
+
+	raw[0] = type;
+	memcpy(&raw[1], payload, len);
+
+	uint16_t crc = link_crc16(raw, len + 1, 0xFFFF);
+	raw[len + 1] = crc & 0xFF;
+	raw[len + 2] = crc >> 8;
+
+	// leading delimiter closes off any text that was sent before this frame
+	enc[0] = 0x00;
+	uint16_t n = cobs_encode(raw, len + 3, &enc[1]) + 1;
+	enc[n++] = 0x00;
+
+	return print_bytes(enc, n) != 0;
+}
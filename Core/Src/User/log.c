@@ -0,0 +1,223 @@
+/*
+ * log.c
+ *
+ *  Created on: Dec 4, 2025
+ *      Author: ryang
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "User/log.h"
+
+#define LOG_FLUSH_MS	250		// how often sites with uncounted repeats are looked at
+
+static LogLimiter *logPending = NULL;	// limited sites that have swallowed occurrences
+
+uint8_t logLevels[LOG_MOD_COUNT] = {
+	[LOG_MOD_INPUT] = LOG_DEFAULT_LEVEL,
+	[LOG_MOD_CONTROL] = LOG_DEFAULT_LEVEL,
+	[LOG_MOD_SERVO] = LOG_DEFAULT_LEVEL,
+	[LOG_MOD_SENSOR] = LOG_DEFAULT_LEVEL,
+	[LOG_MOD_UART] = LOG_DEFAULT_LEVEL,
+};
+
+static const char *const levelNames[] = { "off", "error", "warn", "info", "debug", "trace" };
+static const char *const moduleNames[LOG_MOD_COUNT] = { "input", "control", "servo", "sensor", "uart" };
+
+// case insensitive compare, names in the tables are lowercase
+static int log_name_eq(const char *a, const char *lower)
+{
+	while (*a && *lower) {
+		char c = (*a >= 'A' && *a <= 'Z') ? *a + 32 : *a;
+		if (c != *lower) {
+			return 0;
+		}
+		a++;
+		lower++;
+	}
+	return *a == *lower;
+}
+
+void log_set_level(LogModule mod, uint8_t level)
+{
+	if (mod < LOG_MOD_COUNT && level <= LOG_LVL_TRACE) {
+		logLevels[mod] = level; // single byte store, readers need no lock
+	}
+}
+
+uint8_t log_get_level(LogModule mod)
+{
+	return mod < LOG_MOD_COUNT ? logLevels[mod] : LOG_LVL_OFF;
+}
+
+int log_level_from_name(const char *name)
+{
+	for (int i = 0; i <= LOG_LVL_TRACE; i++) {
+		if (log_name_eq(name, levelNames[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int log_module_from_name(const char *name)
+{
+	for (int i = 0; i < LOG_MOD_COUNT; i++) {
+		if (log_name_eq(name, moduleNames[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+const char *log_level_name(uint8_t level)
+{
+	return level <= LOG_LVL_TRACE ? levelNames[level] : "?";
+}
+
+const char *log_module_name(LogModule mod)
+{
+	return mod < LOG_MOD_COUNT ? moduleNames[mod] : "?";
+}
+
+// the token bucket, 1 if the occurrence may be logged. caller holds the critical section
+static uint8_t log_limit_take(LogLimiter *lim, uint8_t burst, uint32_t period, uint32_t now)
+{
+	if (!lim->started) {
+		lim->started = 1;
+		lim->tokens = burst;
+		lim->refillTick = now;
+	}
+	lim->periodTicks = period;
+
+	// top up one token per elapsed period, keeping the remainder for the next call
+	if (period > 0 && lim->tokens < burst) {
+		uint32_t earned = (now - lim->refillTick) / period;
+		if (earned > 0) {
+			lim->tokens = (earned >= (uint32_t)(burst - lim->tokens)) ? burst : lim->tokens + earned;
+			lim->refillTick += earned * period;
+		}
+	}
+	if (lim->tokens == burst) {
+		lim->refillTick = now; // a full bucket doesn't bank time
+	}
+
+	if (lim->tokens == 0) {
+		if (lim->suppressed++ == 0) {
+			lim->firstSuppressed = now;
+		}
+		lim->lastSuppressed = now;
+		return 0;
+	}
+
+	lim->tokens--;
+	return 1;
+}
+
+// the site's line with " ... repeated N times in X.XXs" on the end
+static void log_repeat_emit(const char *repeatFmt, const uint32_t *args, uint8_t nargs, uint32_t repeats, uint32_t spanMs)
+{
+	uint32_t out[TRACE_MAX_ARGS];
+
+	memcpy(out, args, nargs * sizeof(uint32_t));
+	out[nargs] = repeats;
+	out[nargs + 1] = spanMs / 1000;
+	out[nargs + 2] = (spanMs % 1000) / 10;
+	trace_emit((uint16_t)(uintptr_t)repeatFmt, out, nargs + 3);
+}
+
+void log_limited(LogLimiter *lim, const char *fmt, uint8_t burst, uint32_t periodMs, const uint32_t *args, uint8_t nargs)
+{
+	uint32_t now = xTaskGetTickCount();
+	uint32_t repeats = 0;
+	uint32_t spanMs = 0;
+	uint8_t allowed;
+
+	// the flush timer reads and clears the same state
+	taskENTER_CRITICAL();
+	allowed = log_limit_take(lim, burst, pdMS_TO_TICKS(periodMs), now);
+	if (!allowed) {
+		memcpy(lim->lastArgs, args, nargs * sizeof(uint32_t));
+		lim->nargs = nargs;
+		if (!lim->pending) {
+			lim->pending = 1;
+			lim->next = logPending;
+			logPending = lim;
+		}
+	} else if (lim->suppressed) {
+		repeats = lim->suppressed;
+		spanMs = (now - lim->firstSuppressed) * portTICK_PERIOD_MS;
+		lim->suppressed = 0;
+	}
+	taskEXIT_CRITICAL();
+
+	if (!allowed) {
+		return;
+	}
+	if (repeats) {
+		log_repeat_emit(lim->repeatFmt, args, nargs, repeats, spanMs);
+	} else {
+		trace_emit((uint16_t)(uintptr_t)fmt, args, nargs);
+	}
+}
+
+void log_limit_flush(void)
+{
+	for (;;) {
+		uint32_t now = xTaskGetTickCount();
+		uint32_t args[TRACE_MAX_ARGS - 3];
+		const char *repeatFmt = NULL;
+		uint32_t repeats = 0;
+		uint32_t spanMs = 0;
+		uint8_t nargs = 0;
+
+		// one due site per pass, printed outside the critical section. sites a logged line has
+		// already reported for leave the list on the way
+		taskENTER_CRITICAL();
+		for (LogLimiter **link = &logPending; *link; ) {
+			LogLimiter *lim = *link;
+
+			if (lim->suppressed && now - lim->refillTick < lim->periodTicks) {
+				link = &lim->next; // still inside its period, its next line may carry the count
+				continue;
+			}
+			*link = lim->next;
+			lim->pending = 0;
+			if (lim->suppressed) {
+				repeatFmt = lim->repeatFmt;
+				repeats = lim->suppressed;
+				spanMs = (lim->lastSuppressed - lim->firstSuppressed) * portTICK_PERIOD_MS;
+				nargs = lim->nargs;
+				memcpy(args, lim->lastArgs, nargs * sizeof(uint32_t));
+				lim->suppressed = 0;
+				break;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if (!repeatFmt) {
+			return;
+		}
+		log_repeat_emit(repeatFmt, args, nargs, repeats, spanMs);
+	}
+}
+
+static void log_flush_timer(TimerHandle_t timer)
+{
+	(void)timer;
+	log_limit_flush();
+}
+
+void log_init(void)
+{
+	TimerHandle_t timer = xTimerCreate("LogFlush", pdMS_TO_TICKS(LOG_FLUSH_MS), pdTRUE, NULL, log_flush_timer);
+
+	if (timer) {
+		xTimerStart(timer, 0);
+	}
+}
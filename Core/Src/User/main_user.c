@@ -20,6 +20,8 @@
 #include "User/crane_hal.h"
 #include "User/uart.h"
 #include "User/SensorTask.h"
+#include "User/log.h"
+#include "User/telemetry.h"
 
 
 
@@ -37,13 +39,21 @@ static int cmdIndex = 0;
 static void main_task(void *param){
 
     CraneSensorData s;
+    uint32_t lastSeq = 0;
 
 	while(1){
-		 if (xQueueReceive(sensorQueue, &s, 0) == pdPASS)
+		 if (SensorTask_ReadIfNew(&s, &lastSeq))
 		        {
-		            char buf[64];
-		            sprintf(buf, "Distance: %.2f cm   Normalized: %.2f\r\n", s.heightCm, s.heightNorm);
-		            print_str(buf);
+		            if (s.status == SENSOR_NO_ECHO) {
+		                LOG_INFO(SENSOR, "Distance: no echo");
+		            } else if (s.status == SENSOR_OUT_OF_RANGE) {
+		                LOG_INFO(SENSOR, "Distance: %ld.%02ld cm (out of range)",
+		                		 (long)(s.heightUm / 10000), (long)((s.heightUm / 100) % 100));
+		            } else {
+		                LOG_INFO(SENSOR, "Distance: %ld.%02ld cm   Normalized: %u/%u",
+		                		 (long)(s.heightUm / 10000), (long)((s.heightUm / 100) % 100),
+		                		 s.heightNorm, SENSOR_NORM_ONE);
+		            }
 		        }
 
 		vTaskDelay(10000/portTICK_RATE_MS);
@@ -52,6 +62,7 @@ static void main_task(void *param){
 
 void main_user(){
 	util_init();
+	log_init();
 
 	xTaskCreate(main_task,"Main Task", configMINIMAL_STACK_SIZE + 100, NULL, tskIDLE_PRIORITY + 2, NULL);
 
@@ -61,6 +72,7 @@ void main_user(){
 	ControlTask_Init();
 	UART_StartCommandTask();
 	SensorTask_Init();
+	Telemetry_Init();
 
 	// start scheduler
 	vTaskStartScheduler();
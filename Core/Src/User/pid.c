@@ -0,0 +1,56 @@
+/*
+ * pid.c
+ *
+ *  Created on: Dec 8, 2025
+ *      Author: ryang
+ */
+
+#include "User/pid.h"
+
+static int32_t clamp(int32_t v, int32_t limit)
+{
+	if (v > limit) return limit;
+	if (v < -limit) return -limit;
+	return v;
+}
+
+void Pid_Init(Pid *pid, int32_t kp, int32_t ki, int32_t kd, int32_t outMax, int32_t deadbandUm)
+{
+	pid->kp = kp;
+	pid->ki = ki;
+	pid->kd = kd;
+	pid->outMax = outMax;
+	pid->deadbandUm = deadbandUm;
+	Pid_Reset(pid);
+}
+
+void Pid_Reset(Pid *pid)
+{
+	pid->iTerm = 0;
+	pid->saturated = 0;
+}
+
+int32_t Pid_Update(Pid *pid, int32_t errorUm, int32_t velUmS, int32_t ffUmS, uint32_t dtMs)
+{
+	// close enough and nowhere to go, let the axis rest
+	if (ffUmS == 0 && errorUm <= pid->deadbandUm && errorUm >= -pid->deadbandUm) {
+		pid->saturated = 0;
+		return 0;
+	}
+
+	// 64 bit intermediates, a 20 cm error times a gain of a few thousand overflows 32
+	int32_t p = (int32_t)(((int64_t)pid->kp * errorUm) / 1000);
+	int32_t d = (int32_t)(((int64_t)pid->kd * (ffUmS - velUmS)) / 1000);
+	int32_t di = (int32_t)(((int64_t)pid->ki * errorUm * dtMs) / 1000000);
+	int32_t out = ffUmS + p + pid->iTerm + d;
+
+	// conditional integration: no integrating while clipped in the direction the error pushes
+	if (!((out >= pid->outMax && errorUm > 0) || (out <= -pid->outMax && errorUm < 0))) {
+		int32_t iTerm = clamp(pid->iTerm + di, pid->outMax);
+		out += iTerm - pid->iTerm;
+		pid->iTerm = iTerm;
+	}
+
+	pid->saturated = (out > pid->outMax || out < -pid->outMax);
+	return clamp(out, pid->outMax);
+}
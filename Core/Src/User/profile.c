@@ -0,0 +1,157 @@
+/*
+ * profile.c
+ *
+ *  Created on: Dec 9, 2025
+ *      Author: ryang
+ */
+
+#include "User/profile.h"
+
+// integer square root, bit by bit (no fpu)
+static uint32_t isqrt64(uint64_t x)
+{
+	uint64_t res = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > x) bit >>= 2;
+	while (bit) {
+		if (x >= res + bit) {
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)res;
+}
+
+// ramp times for a speed up to v: jerk up, hold aMax if there's time, jerk down.
+// returns the speed the rounded times actually reach
+static int32_t plan_ramp(const Profile *prof, int32_t v, uint32_t *tJerk, uint32_t *tAcc, int32_t *aPeak)
+{
+	if ((int64_t)v * prof->jMax >= (int64_t)prof->aMax * prof->aMax) {
+		*tJerk = (uint32_t)(((int64_t)prof->aMax * 1000) / prof->jMax);
+		*tAcc = (uint32_t)(((int64_t)v * 1000) / prof->aMax) + *tJerk;
+	} else {
+		// never reaches aMax, two jerk ramps back to back
+		*tJerk = isqrt64(((uint64_t)v * 1000000) / (uint32_t)prof->jMax);
+		*tAcc = 2 * *tJerk;
+	}
+	*aPeak = (int32_t)(((int64_t)prof->jMax * *tJerk) / 1000);
+	return (int32_t)(((int64_t)*aPeak * (*tAcc - *tJerk)) / 1000);
+}
+
+// distance covered tau ms into the speed up (0..tAcc), and the speed there
+static int64_t ramp_at(const Profile *prof, uint32_t tau, int32_t *vel)
+{
+	int64_t j = prof->jMax;
+	int64_t a = prof->aPeak;
+	int64_t tj = prof->tJerk;
+	int64_t t = tau;
+
+	if (t < tj) {
+		*vel = (int32_t)((j * t * t) / 2000000);
+		return (j * t * t * t) / 6000000000LL;
+	}
+	if (t <= (int64_t)prof->tAcc - tj) {
+		int64_t v1 = (j * tj * tj) / 2000000;
+		int64_t s1 = (j * tj * tj * tj) / 6000000000LL;
+		int64_t u = t - tj;
+		*vel = (int32_t)(v1 + (a * u) / 1000);
+		return s1 + (v1 * u) / 1000 + (a * u * u) / 2000000;
+	}
+
+	// last ramp mirrors the first about the end of the speed up
+	int64_t u = (int64_t)prof->tAcc - t;
+	*vel = (int32_t)(prof->vPeak - (j * u * u) / 2000000);
+	return ((int64_t)prof->vPeak * prof->tAcc) / 2000 - ((int64_t)prof->vPeak * u) / 1000 + (j * u * u * u) / 6000000000LL;
+}
+
+void Profile_Init(Profile *prof, int32_t vMax, int32_t aMax, int32_t jMax)
+{
+	prof->vMax = vMax;
+	prof->aMax = aMax;
+	prof->jMax = jMax;
+	Profile_Start(prof, 0, 0);
+}
+
+void Profile_Start(Profile *prof, int32_t start, int32_t target)
+{
+	int64_t dist = (target >= start) ? (int64_t)target - start : (int64_t)start - target;
+	uint32_t tJerk, tAcc;
+	int32_t aPeak;
+	int32_t v = plan_ramp(prof, prof->vMax, &tJerk, &tAcc, &aPeak);
+
+	// speeding up and slowing down again covers v * tAcc. too far for this move: largest peak
+	// speed that fits, by bisection since the ramp shape changes with it
+	if (dist == 0) {
+		v = 0;
+		tJerk = 0;
+		tAcc = 0;
+		aPeak = 0;
+	} else if ((int64_t)v * tAcc / 1000 > dist) {
+		int32_t lo = 0;
+		int32_t hi = prof->vMax;
+		while (hi - lo > 1) {
+			int32_t mid = lo + (hi - lo) / 2;
+			int32_t reach = plan_ramp(prof, mid, &tJerk, &tAcc, &aPeak);
+			if ((int64_t)reach * tAcc / 1000 <= dist) lo = mid; else hi = mid;
+		}
+		v = plan_ramp(prof, lo, &tJerk, &tAcc, &aPeak);
+	}
+
+	prof->start = start;
+	prof->target = target;
+	prof->dir = (target >= start) ? 1 : -1;
+	prof->vPeak = v;
+	prof->aPeak = aPeak;
+	prof->tJerk = tJerk;
+	prof->tAcc = tAcc;
+	prof->tCruise = v ? (uint32_t)(((dist - (int64_t)v * tAcc / 1000) * 1000) / v) : 0;
+	prof->elapsed = 0;
+	prof->pos = start;
+	prof->vel = 0;
+}
+
+void Profile_Step(Profile *prof, uint32_t dtMs)
+{
+	uint32_t total = Profile_Duration(prof);
+	uint32_t t;
+	int64_t s;
+	int32_t v;
+
+	prof->elapsed = (prof->elapsed + dtMs < total) ? prof->elapsed + dtMs : total;
+	t = prof->elapsed;
+
+	if (t >= total) {
+		// rounding leaves the plan a few um short at most, land on the target exactly
+		prof->pos = prof->target;
+		prof->vel = 0;
+		return;
+	}
+
+	if (t < prof->tAcc) {
+		s = ramp_at(prof, t, &v);
+	} else if (t < prof->tAcc + prof->tCruise) {
+		s = ramp_at(prof, prof->tAcc, &v) + ((int64_t)prof->vPeak * (t - prof->tAcc)) / 1000;
+		v = prof->vPeak;
+	} else {
+		// slowing down is the speed up backwards from the end
+		int64_t full = ((int64_t)prof->vPeak * prof->tAcc) + ((int64_t)prof->vPeak * prof->tCruise);
+		s = full / 1000 - ramp_at(prof, total - t, &v);
+	}
+
+	prof->pos = prof->start + prof->dir * (int32_t)s;
+	prof->vel = prof->dir * v;
+}
+
+uint8_t Profile_Done(const Profile *prof)
+{
+	return prof->elapsed >= Profile_Duration(prof);
+}
+
+uint32_t Profile_Duration(const Profile *prof)
+{
+	return 2 * prof->tAcc + prof->tCruise;
+}
@@ -0,0 +1,181 @@
+/*
+ * sequence.c
+ *
+ *  Created on: Dec 10, 2025
+ *      Author: ryang
+ */
+
+#include <string.h>
+
+#include "User/sequence.h"
+#include "User/InputTask.h"
+#include "User/ControlTask.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// the original auto route: first platform, swing out and pick up, back to centre,
+// up and over the top platform, drop off, back to centre and down to the bottom.
+// the swing back to centre starts once the freight is lifted clear (7.5 cm) and the swing over
+// the top platform once the load is above it (14 cm), both while the vertical move finishes
+#define H(um, ctrl, start, clear)	AXIS_VERTICAL, SEQ_MOVE_HEIGHT, ctrl, start, um, 5000, 15000, clear
+#define SWING(ms, start, clear)		AXIS_PLATFORM, SEQ_MOVE_TIMED, 0, start, ms, 0, 2000, clear
+
+static const SeqTable seqDefault = {
+	.steps = {
+		{ H(60000,  VERT_CTRL_PROFILE, SEQ_START_AFTER, 0) },		// 6 cm baseline
+		{ SWING(600,  SEQ_START_AFTER, 0) },						// right
+		{ H(80000,  VERT_CTRL_PROFILE, SEQ_START_AFTER, 0) },		// up 2 cm, pick up
+		{ SWING(-600, SEQ_START_ABOVE, 75000) },					// left, centre
+		{ H(147500, VERT_CTRL_PROFILE, SEQ_START_AFTER, 0) },		// 14.75 cm, clear the top platform
+		{ SWING(-600, SEQ_START_ABOVE, 140000) },					// left, over the top platform
+		{ H(100000, VERT_CTRL_PROFILE, SEQ_START_AFTER, 0) },		// down to 10 cm, drop off
+		{ SWING(600,  SEQ_START_AFTER, 0) },						// right, centre
+		{ H(20000,  VERT_CTRL_PROFILE, SEQ_START_AFTER, 0) },		// 2 cm, the track bottoms out about here
+	},
+	.count = 9,
+};
+
+#undef H
+#undef SWING
+
+static SeqTable seqActive;
+static SeqTable seqStaging;
+
+void Seq_Init(void)
+{
+	seqActive = seqDefault;
+}
+
+SeqTable *Seq_Active(void)
+{
+	return &seqActive;
+}
+
+SeqTable *Seq_Staging(void)
+{
+	return &seqStaging;
+}
+
+dir_t Seq_StepDir(const SeqStep *step)
+{
+	// rising is DIRDOWN on the vertical servo (wired flipped), right is DIRUP on the platform
+	if (step->axis == AXIS_VERTICAL) {
+		return step->target > 0 ? DIRDOWN : DIRUP;
+	}
+	return step->target > 0 ? DIRUP : DIRDOWN;
+}
+
+// is there a limit switch in the input table for this axis and direction
+static uint8_t seq_limit_wired(uint8_t axis, dir_t dir)
+{
+#define SEQ_LIMIT_MATCH(label, close, open, ax, d, pair) || ((d) != DIRSTOP && (ax) == axis && (d) == dir)
+	return 0 INPUT_TABLE(SEQ_LIMIT_MATCH, INPUT_IGNORE_EVENT);
+#undef SEQ_LIMIT_MATCH
+}
+
+const char *Seq_Validate(const SeqTable *table, uint8_t *badStep)
+{
+	*badStep = 0;
+	if (table->count == 0 || table->count > SEQ_MAX_STEPS) {
+		return "no steps";
+	}
+
+	for (uint8_t i = 0; i < table->count; i++)
+	{
+		const SeqStep *st = &table->steps[i];
+		*badStep = i;
+
+		if (st->axis > AXIS_PLATFORM) {
+			return "bad axis";
+		}
+		if (st->timeoutMs < SEQ_TIMEOUT_MIN_MS || st->timeoutMs > SEQ_TIMEOUT_MAX_MS) {
+			return "timeout out of range";
+		}
+		if (st->start > SEQ_START_BELOW) {
+			return "bad start";
+		}
+		if (st->start != SEQ_START_AFTER) {
+			// overlapping means overlapping the step before, on the other axis
+			if (i == 0) {
+				return "first step can't overlap";
+			}
+			if (table->steps[i - 1].axis == st->axis) {
+				return "overlaps its own axis";
+			}
+		}
+		if ((st->start == SEQ_START_ABOVE || st->start == SEQ_START_BELOW) &&
+			(st->clearUm < SEQ_HEIGHT_MIN_UM || st->clearUm > SEQ_HEIGHT_MAX_UM)) {
+			return "clearance out of range";
+		}
+
+		switch (st->move) {
+		case SEQ_MOVE_HEIGHT:
+			if (st->axis != AXIS_VERTICAL) {
+				return "height move on the platform";
+			}
+			if (st->target < SEQ_HEIGHT_MIN_UM || st->target > SEQ_HEIGHT_MAX_UM) {
+				return "height out of range";
+			}
+			if (st->tolUm < SEQ_TOL_MIN_UM || st->tolUm > SEQ_TOL_MAX_UM) {
+				return "tolerance out of range";
+			}
+			if (st->ctrl > VERT_CTRL_PROFILE) {
+				return "bad controller";
+			}
+			break;
+		case SEQ_MOVE_TIMED:
+			if (st->target == 0) {
+				return "no duration";
+			}
+			if ((uint32_t)(st->target < 0 ? -st->target : st->target) >= st->timeoutMs) {
+				return "duration past timeout";
+			}
+			break;
+		case SEQ_MOVE_LIMIT:
+			if (st->target == 0) {
+				return "no direction";
+			}
+			if (!seq_limit_wired(st->axis, Seq_StepDir(st))) {
+				return "no limit switch that way";
+			}
+			break;
+		default:
+			return "bad move";
+		}
+	}
+	return NULL;
+}
+
+// the check and the copy go in one critical section: ControlTask outranks the console, and a
+// pending "auto" (or a button) could otherwise start a run on a half copied table
+static uint8_t seq_swap_in(const SeqTable *table)
+{
+	uint8_t ok = 0;
+
+	taskENTER_CRITICAL();
+	if (!ControlTask_AutoActive()) {
+		seqActive = *table;
+		ok = 1;
+	}
+	taskEXIT_CRITICAL();
+	return ok;
+}
+
+const char *Seq_Load(uint8_t *badStep)
+{
+	const char *err = Seq_Validate(&seqStaging, badStep);
+
+	if (err) {
+		return err;
+	}
+	if (!seq_swap_in(&seqStaging)) {
+		*badStep = 0;
+		return "auto mode running";
+	}
+	return NULL;
+}
+
+uint8_t Seq_LoadDefault(void)
+{
+	return seq_swap_in(&seqDefault);
+}
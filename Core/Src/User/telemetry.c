@@ -0,0 +1,98 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Dec 4, 2025
+ *      Author: ryang
+ */
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "User/telemetry.h"
+#include "User/link.h"
+#include "User/ControlTask.h"
+#include "User/SensorTask.h"
+#include "User/crane_hal.h"
+
+#define TELEMETRY_DEFAULT_HZ	0	// off until requested from the console ("telem <hz>")
+
+static TaskHandle_t telemetryTaskHandle = NULL;
+static volatile uint16_t telemetryHz = TELEMETRY_DEFAULT_HZ;
+
+static void TelemetryTask(void *arg)
+{
+	TelemetryFrame frame = {0};
+	CraneSensorData s = {0};
+	SensorHealth health;
+	TickType_t lastWake = xTaskGetTickCount();
+
+	for (;;)
+	{
+		uint16_t hz = telemetryHz;
+
+		// stream off, sleep until the rate is changed
+		if (hz == 0) {
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			lastWake = xTaskGetTickCount();
+			continue;
+		}
+
+		// non-destructive, the controller still gets the sample
+		SensorTask_GetLatest(&s);
+
+		frame.tick = xTaskGetTickCount();
+		frame.heightUm = s.heightUm;
+		frame.heightNorm = s.heightNorm;
+		frame.mode = (uint8_t)ControlTask_GetMode();
+		frame.autoStep = ControlTask_GetAutoStep();
+		frame.ccr1 = (uint16_t)__HAL_TIM_GET_COMPARE(&htim1, TIM_CHANNEL_1);
+		frame.ccr2 = (uint16_t)__HAL_TIM_GET_COMPARE(&htim1, TIM_CHANNEL_2);
+		frame.controlQueueDepth = (uint8_t)ControlTask_QueueDepth();
+		frame.servoQueueDepth = servo_Queue ? (uint8_t)uxQueueMessagesWaiting(servo_Queue) : 0;
+		frame.heightFiltUm = s.heightFiltUm;
+		frame.velocityUmS = s.velocityUmS;
+		frame.sensorStatus = s.status;
+
+		SensorTask_GetHealth(&health);
+		frame.echoTimeouts = (uint16_t)health.timeouts;
+		frame.outOfRange = (uint16_t)health.outOfRange;
+		frame.outliers = (uint16_t)health.outliers;
+		frame.sampleHz = (uint8_t)health.achievedHz;
+		frame.latencyUs = (uint16_t)health.latencyLastUs;
+
+		link_send_frame(LINK_FRAME_TELEMETRY, &frame, sizeof(frame));
+		frame.seq++;
+
+		vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / hz));
+	}
+}
+
+void Telemetry_SetRate(uint16_t hz)
+{
+	if (hz != 0 && hz < TELEMETRY_MIN_HZ) hz = TELEMETRY_MIN_HZ;
+	if (hz > TELEMETRY_MAX_HZ) hz = TELEMETRY_MAX_HZ;
+
+	telemetryHz = hz;
+
+	// wake the task in case it is parked with the stream off
+	if (telemetryTaskHandle) {
+		xTaskNotifyGive(telemetryTaskHandle);
+	}
+}
+
+uint16_t Telemetry_GetRate(void)
+{
+	return telemetryHz;
+}
+
+void Telemetry_Init(void)
+{
+	xTaskCreate(TelemetryTask,
+		"TelemetryTask",
+		256,
+		NULL,
+		tskIDLE_PRIORITY + 1,
+		&telemetryTaskHandle);
+}
@@ -0,0 +1,29 @@
+/*
+ * trace.c
+ *
+ *  Created on: Dec 3, 2025
+ *      Author: ryang
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "User/trace.h"
+#include "User/link.h"
+
+void trace_emit(uint16_t fmtId, const uint32_t *args, uint8_t nargs)
+{
+	TraceRecord rec;
+
+	if (nargs > TRACE_MAX_ARGS) {
+		nargs = TRACE_MAX_ARGS;
+	}
+
+	rec.fmtId = fmtId;
+	rec.tick = xTaskGetTickCount();
+	memcpy(rec.args, args, nargs * sizeof(uint32_t));
+
+	link_send_frame(LINK_FRAME_TRACE, &rec, sizeof(rec) - (TRACE_MAX_ARGS - nargs) * sizeof(uint32_t));
+}
@@ -2,19 +2,38 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "string.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include "User/util.h"
 #include "User/uart.h"
 #include "User/ControlTask.h"
+#include "User/telemetry.h"
+#include "User/log.h"
+#include "User/SensorTask.h"
+#include "User/crane_hal.h"
 
+#define UART_RX_DMA_SIZE	64	// circular dma buffer, must hold more than one idle gap worth of input
+#define UART_STATS_MAX_TASKS	12	// tasks listed by the "tasks" command
+#define BENCH_SAMPLES		256		// synthetic echoes per "bench" run
+#define BENCH_YIELDS		64		// yields averaged per context switch figure
 
 // extern from STM32 HAL
 extern UART_HandleTypeDef huart2;
 
 char uartCommand[50];
-static int cmdIndex = 0;
 
 static TaskHandle_t uartTaskHandle = NULL;
 
+// usart2 rx runs on circular dma, the idle line / half / full events hand us whatever arrived
+static uint8_t rxDma[UART_RX_DMA_SIZE];
+static uint16_t rxPos = 0;				// first byte in rxDma not yet processed
+
+// line being assembled in the isr, copied to uartCommand once enter is seen
+static char rxLine[sizeof(uartCommand)];
+static uint16_t rxLineLen = 0;
+static volatile uint8_t commandReady = 0;	// uartCommand holds a line the task hasn't finished with
+static volatile uint32_t commandsDropped = 0;
+
 //helper function for comparing strings for match
 int stricmp(const char *a, const char *b)
 {
@@ -28,74 +47,675 @@ int stricmp(const char *a, const char *b)
     return *a - *b;
 }
 
+// match "name" or "name <arg>" (case insensitive), arg points at the text after the space
+static int UART_MatchCommand(const char *cmd, const char *name, const char **arg)
+{
+    size_t n = strlen(name);
 
-static void UART_CommandTask(void *param)
+    for (size_t i = 0; i < n; i++)
+    {
+        char c = (cmd[i] >= 'A' && cmd[i] <= 'Z') ? cmd[i] + 32 : cmd[i];
+        if (c != name[i]) return 0;
+    }
+    if (cmd[n] != '\0' && cmd[n] != ' ') return 0;
+
+    *arg = (cmd[n] == ' ') ? &cmd[n + 1] : &cmd[n];
+    return 1;
+}
+
+// (re)start reception into the circular buffer
+static void UART_StartReceive(void)
 {
-    print_str("UART: Type 'manual', 'auto', or 'cal'\r\n"); // print input options to user
+    rxPos = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rxDma, sizeof(rxDma));
+}
 
-    char ch;
+// collect bytes into the line buffer, wake the command task when a line is complete
+static void UART_ProcessRx(uint16_t from, uint16_t to, BaseType_t *woken)
+{
+    char echo[UART_RX_DMA_SIZE + 1];
+    uint16_t echoLen = 0;
 
-    while (1)
+    for (uint16_t i = from; i < to; i++)
     {
-        // read 1 character received over uart
-        if (HAL_UART_Receive(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY) == HAL_OK)
+        char ch = (char)rxDma[i];
+        echo[echoLen++] = ch;
+
+        if (ch == '\r' || ch == '\n')
         {
-            // echo what was input
-            HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
-
-            // check if enter was pressed
-            if (ch == '\r' || ch == '\n')
-            {
-                uartCommand[cmdIndex] = '\0'; // terminate string
-
-                uartCommand[cmdIndex] = '\0'; // terminate string
-
-                // reprint what user typed
-                print_str("\r\nCommand received: ");
-                print_str(uartCommand);
-                print_str("\r\n");
-
-                // check what was input to see if it aligns with our modes
-                if (stricmp(uartCommand, "manual") == 0)
-                {
-                    ControlTask_SetMode(MODE_MANUAL);
-                    print_str("Manual mode selected\r\n");
-                }
-                else if (stricmp(uartCommand, "auto") == 0)
-                {
-                    ControlTask_SetMode(MODE_AUTO);
-                    print_str("Auto mode selected\r\n");
-                }
-                else if (stricmp(uartCommand, "cal") == 0)
-                {
-                    ControlTask_SetMode(MODE_CAL);
-                    print_str("Calibration mode selected\r\n");
-                }
-                // if input not aligned with modes, print error msg
-                else if (strlen(uartCommand) > 0)
-                {
-                    print_str("Unknown command\r\n");
-                }
-
-                // Reset input buffer
-                memset(uartCommand, 0, sizeof(uartCommand));
-                cmdIndex = 0;
-
-
-                // reset the buffer
-                memset(uartCommand, 0, sizeof(uartCommand));
-                cmdIndex = 0;
+            if (rxLineLen == 0) {
+                continue; // empty line or second half of \r\n
+            }
+
+            rxLine[rxLineLen] = '\0';
+            rxLineLen = 0;
+
+            // hand the line over unless the task is still busy with the previous one
+            if (!commandReady) {
+                memcpy(uartCommand, rxLine, sizeof(uartCommand));
+                commandReady = 1;
+                vTaskNotifyGiveFromISR(uartTaskHandle, woken);
+            } else {
+                commandsDropped++;
+            }
+        }
+        else if (rxLineLen < sizeof(rxLine) - 1)
+        {
+            rxLine[rxLineLen++] = ch;
+        }
+    }
+
+    // echo what was input
+    if (echoLen > 0) {
+        echo[echoLen] = '\0';
+        print_str_ISR(echo);
+    }
+}
+
+// idle line, half and full transfer events from the rx dma (Size = current write position)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart->Instance != USART2) {
+        return;
+    }
+
+    BaseType_t woken = pdFALSE;
+
+    if (Size != rxPos) {
+        UART_ProcessRx(rxPos, Size, &woken);
+        rxPos = (Size == sizeof(rxDma)) ? 0 : Size; // wrap with the dma
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+// overrun/framing errors abort the dma reception, just start it again. a dma error can abort
+// the transmit too, the print ring picks that up
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2) {
+        return;
+    }
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        UART_StartReceive();
+    }
+    util_tx_error();
+}
+
+static void UART_LogCommand(const char *arg, char *buf, size_t size)
+{
+    char name[12];
+    const char *space = strchr(arg, ' ');
+    int level;
+
+    if (*arg == '\0')
+    {
+        for (int m = 0; m < LOG_MOD_COUNT; m++) {
+            snprintf(buf, size, "  %-8s %s\r\n", log_module_name(m), log_level_name(log_get_level(m)));
+            print_str(buf);
+        }
+        return;
+    }
+
+    if (space == NULL)
+    {
+        // one word, a level for every module
+        if ((level = log_level_from_name(arg)) < 0) {
+            print_str("Levels: off error warn info debug trace\r\n");
+            return;
+        }
+        for (int m = 0; m < LOG_MOD_COUNT; m++) {
+            log_set_level(m, level);
+        }
+    }
+    else
+    {
+        size_t len = (size_t)(space - arg);
+        int mod;
+
+        if (len >= sizeof(name)) len = sizeof(name) - 1;
+        memcpy(name, arg, len);
+        name[len] = '\0';
+
+        if ((mod = log_module_from_name(name)) < 0) {
+            print_str("Modules: input control servo sensor uart\r\n");
+            return;
+        }
+        if ((level = log_level_from_name(space + 1)) < 0) {
+            print_str("Levels: off error warn info debug trace\r\n");
+            return;
+        }
+        log_set_level(mod, level);
+    }
+
+    if (level > LOG_COMPILE_LEVEL) {
+        print_str("Note: levels above the build's compile floor stay silent\r\n");
+    }
+    print_str("Log levels updated\r\n");
+}
+
+static const char *const ctrlNames[] = { "bang", "pid ", "prof" };
+static const char *const moveNames[] = { "height", "timed", "limit" };
+static const char *const startNames[] = { "after", "with", "above", "below" };
+
+static void UART_SeqList(const SeqTable *table, uint8_t withTimes, char *buf, size_t size)
+{
+    SeqStats stats;
+
+    ControlTask_GetSeqStats(&stats);
+    print_str("  #   axis move    target    tol  timeout ctrl start  clear   last ms\r\n");
+    for (uint8_t i = 0; i < table->count; i++)
+    {
+        const SeqStep *st = &table->steps[i];
+        snprintf(buf, size, "  %-2u  %c    %-6s %7ld %6ld %8lu %s %-5s %6ld %8lu\r\n", i,
+                 st->axis == AXIS_VERTICAL ? 'v' : 'p', st->move <= SEQ_MOVE_LIMIT ? moveNames[st->move] : "?",
+                 (long)st->target, (long)st->tolUm, (unsigned long)st->timeoutMs,
+                 st->move == SEQ_MOVE_HEIGHT && st->ctrl <= VERT_CTRL_PROFILE ? ctrlNames[st->ctrl] : "    ",
+                 st->start <= SEQ_START_BELOW ? startNames[st->start] : "?",
+                 st->start >= SEQ_START_ABOVE ? (long)st->clearUm : 0L,
+                 withTimes ? (unsigned long)stats.stepMs[i] : 0UL);
+        print_str(buf);
+    }
+}
+
+// auto sequence table: "seq" lists the active one and what the last run took, "seq new" starts
+// a staged table, "seq add ..." appends a step to it, "seq staged" lists it, "seq load" checks
+// and activates it, "seq default" goes back to the built in route
+//   seq add v height <um> <tol um> <timeout ms> [profile|pid|bang] [start]
+//   seq add v|p timed <+-ms> <timeout ms> [start]      (+ is rising / right)
+//   seq add v|p limit <+-1> <timeout ms> [start]
+// start is "with" (alongside the step before), "above <um>" or "below <um>" (alongside it, once
+// the height is past that), nothing waits for every earlier step
+static void UART_SeqCommand(const char *arg, char *buf, size_t size)
+{
+    SeqTable *staged = Seq_Staging();
+    const char *err;
+    uint8_t bad;
+
+    if (*arg == '\0')
+    {
+        SeqStats stats;
+        uint32_t cycPerUs = SystemCoreClock / 1000000;
+
+        UART_SeqList(Seq_Active(), 1, buf, size);
+        ControlTask_GetSeqStats(&stats);
+        snprintf(buf, size, "Last run %lu ms (%u steps), runs %lu, aborted %lu\r\n", (unsigned long)stats.totalMs,
+                 stats.steps, (unsigned long)stats.runs, (unsigned long)stats.aborts);
+        print_str(buf);
+        // overlapping steps is where the run beats its steps added up
+        snprintf(buf, size, "Steps add up to %lu ms, overlap saved %ld ms\r\n", (unsigned long)stats.serialMs,
+                 (long)stats.serialMs - (long)stats.totalMs);
+        print_str(buf);
+        snprintf(buf, size, "Step hand over %lu cyc, %lu us (max %lu cyc)\r\n", (unsigned long)stats.transitionLastCyc,
+                 (unsigned long)(stats.transitionLastCyc / cycPerUs), (unsigned long)stats.transitionMaxCyc);
+        print_str(buf);
+    }
+    else if (UART_MatchCommand(arg, "new", &arg))
+    {
+        staged->count = 0;
+        print_str("Staged table cleared\r\n");
+    }
+    else if (UART_MatchCommand(arg, "add", &arg))
+    {
+        SeqStep st = {0};
+        char *end;
+
+        if (staged->count >= SEQ_MAX_STEPS) {
+            print_str("Staged table full\r\n");
+            return;
+        }
+
+        if (UART_MatchCommand(arg, "v", &arg)) st.axis = AXIS_VERTICAL;
+        else if (UART_MatchCommand(arg, "p", &arg)) st.axis = AXIS_PLATFORM;
+        else { print_str("Axis is v or p\r\n"); return; }
+
+        if (UART_MatchCommand(arg, "height", &arg)) st.move = SEQ_MOVE_HEIGHT;
+        else if (UART_MatchCommand(arg, "timed", &arg)) st.move = SEQ_MOVE_TIMED;
+        else if (UART_MatchCommand(arg, "limit", &arg)) st.move = SEQ_MOVE_LIMIT;
+        else { print_str("Move is height, timed or limit\r\n"); return; }
+
+        st.target = strtol(arg, &end, 10);
+        if (st.move == SEQ_MOVE_HEIGHT) {
+            st.tolUm = strtol(end, &end, 10);
+        }
+        st.timeoutMs = strtoul(end, &end, 10);
+        while (*end == ' ') end++;
+        arg = end;
+
+        st.ctrl = VERT_CTRL_PROFILE;
+        st.start = SEQ_START_AFTER;
+        while (*arg != '\0')
+        {
+            if (UART_MatchCommand(arg, "profile", &arg)) st.ctrl = VERT_CTRL_PROFILE;
+            else if (UART_MatchCommand(arg, "pid", &arg)) st.ctrl = VERT_CTRL_PID;
+            else if (UART_MatchCommand(arg, "bang", &arg)) st.ctrl = VERT_CTRL_BANG;
+            else if (UART_MatchCommand(arg, "with", &arg)) st.start = SEQ_START_WITH;
+            else if (UART_MatchCommand(arg, "above", &arg)) {
+                st.start = SEQ_START_ABOVE;
+                st.clearUm = strtol(arg, &end, 10);
+                arg = end;
+            }
+            else if (UART_MatchCommand(arg, "below", &arg)) {
+                st.start = SEQ_START_BELOW;
+                st.clearUm = strtol(arg, &end, 10);
+                arg = end;
+            }
+            else { print_str("Expected profile, pid, bang, with, above <um> or below <um>\r\n"); return; }
+            while (*arg == ' ') arg++;
+        }
+
+        staged->steps[staged->count++] = st;
+        snprintf(buf, size, "Staged step %u\r\n", staged->count - 1);
+        print_str(buf);
+    }
+    else if (UART_MatchCommand(arg, "staged", &arg))
+    {
+        UART_SeqList(staged, 0, buf, size);
+        err = Seq_Validate(staged, &bad);
+        if (err) {
+            snprintf(buf, size, "Not loadable, step %u: ", bad);
+            print_str(buf);
+            print_str((char *)err);
+            print_str("\r\n");
+        }
+    }
+    else if (UART_MatchCommand(arg, "load", &arg))
+    {
+        err = Seq_Load(&bad);
+        if (err) {
+            snprintf(buf, size, "Rejected, step %u: ", bad);
+            print_str(buf);
+            print_str((char *)err);
+            print_str("\r\n");
+        } else {
+            snprintf(buf, size, "Loaded %u steps\r\n", Seq_Active()->count);
+            print_str(buf);
+        }
+    }
+    else if (UART_MatchCommand(arg, "default", &arg))
+    {
+        print_str(Seq_LoadDefault() ? "Built in route loaded\r\n" : "Rejected, auto mode running\r\n");
+    }
+    else
+    {
+        print_str("Usage: seq [new|add ...|staged|load|default]\r\n");
+    }
+}
+
+static void UART_PidCommand(const char *arg, char *buf, size_t size)
+{
+    char *end;
+    int32_t kp, ki, kd;
+
+    if (UART_MatchCommand(arg, "gains", &arg))
+    {
+        kp = strtol(arg, &end, 10);
+        ki = strtol(end, &end, 10);
+        kd = strtol(end, &end, 10);
+        if (end == arg || kp < 0 || ki < 0 || kd < 0) {
+            print_str("Usage: pid gains <kp> <ki> <kd> (x1000)\r\n");
+            return;
+        }
+        ControlTask_SetVerticalGains(kp, ki, kd);
+    }
+    else if (*arg != '\0')
+    {
+        unsigned long step = strtoul(arg, &end, 10);
+        while (*end == ' ') end++;
+        VertCtrl ctrl = VERT_CTRL_BANG;
+        if (stricmp(end, "profile") == 0) ctrl = VERT_CTRL_PROFILE;
+        else if (stricmp(end, "pid") == 0) ctrl = VERT_CTRL_PID;
+        else if (stricmp(end, "bang") == 0) ctrl = VERT_CTRL_BANG;
+        else end = (char *)arg; // not a controller name
+
+        if (end == arg || step >= Seq_Active()->count || Seq_Active()->steps[step].move != SEQ_MOVE_HEIGHT) {
+            print_str("Usage: pid <height step> profile|pid|bang\r\n");
+            return;
+        }
+        ControlTask_SetStepController((uint8_t)step, ctrl);
+    }
+
+    ControlTask_GetVerticalGains(&kp, &ki, &kd);
+    snprintf(buf, size, "Vertical gains kp %ld ki %ld kd %ld (x1000)\r\n", (long)kp, (long)ki, (long)kd);
+    print_str(buf);
+
+    // only the steps that have moved vertically have stats
+    const SeqTable *table = Seq_Active();
+    print_str("  step  ctrl  settle ms  overshoot um  runs\r\n");
+    for (uint8_t i = 0; i < table->count; i++)
+    {
+        VertStepStats st;
+        ControlTask_GetStepStats(i, &st);
+        if (st.runs == 0 || table->steps[i].move != SEQ_MOVE_HEIGHT) {
+            continue;
+        }
+        snprintf(buf, size, "  %-2u    %s  %9lu  %12ld  %lu\r\n", i,
+                 ctrlNames[table->steps[i].ctrl],
+                 (unsigned long)st.settleMs, (long)st.overshootUm, (unsigned long)st.runs);
+        print_str(buf);
+    }
+}
+
+// per task cpu share since the previous "tasks" command (run time stats, 10us units)
+static void UART_TasksCommand(char *buf, size_t size)
+{
+    static TaskStatus_t status[UART_STATS_MAX_TASKS];
+    static uint32_t lastRunTime[UART_STATS_MAX_TASKS + 1];	// indexed by task number
+    static uint32_t lastTotal = 0;
+    uint32_t total;
+    UBaseType_t n = uxTaskGetSystemState(status, UART_STATS_MAX_TASKS, &total);
+    uint32_t elapsed = total - lastTotal;
+
+    lastTotal = total;
+    if (elapsed == 0) elapsed = 1;
+
+    print_str("  task              cpu%   stack free\r\n");
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        UBaseType_t num = status[i].xTaskNumber;
+        uint32_t ran = status[i].ulRunTimeCounter;
+
+        if (num <= UART_STATS_MAX_TASKS) {
+            uint32_t delta = ran - lastRunTime[num];
+            lastRunTime[num] = ran;
+            ran = delta;
+        }
+
+        // tenths of a percent without 64 bit math
+        uint32_t permille = (elapsed >= 1000) ? ran / (elapsed / 1000) : (ran * 1000) / elapsed;
+        snprintf(buf, size, "  %-16s %3lu.%lu   %u\r\n", status[i].pcTaskName,
+                 (unsigned long)(permille / 10), (unsigned long)(permille % 10),
+                 (unsigned)status[i].usStackHighWaterMark);
+        print_str(buf);
+    }
+}
+
+static volatile uint32_t benchYieldCyc = 0;
+
+// cycles for BENCH_YIELDS taskYIELD round trips
+static uint32_t UART_YieldLoop(void)
+{
+    uint32_t total = 0;
+
+    for (uint8_t i = 0; i < BENCH_YIELDS; i++)
+    {
+        uint32_t start = DWT->CYCCNT;
+        taskYIELD();
+        total += DWT->CYCCNT - start;
+    }
+    return total;
+}
+
+// a fresh task has no fp context and this one never gets one: integer code only, nothing here
+// touches the fpu. it runs above the console task, so it is done by the time xTaskCreate returns
+static void UART_YieldBenchTask(void *param)
+{
+    (void)param;
+
+    benchYieldCyc = UART_YieldLoop() / BENCH_YIELDS;
+    vTaskDelete(NULL);
+}
+
+// average cycles for a taskYIELD round trip. without withFp it's measured in a task of its own
+// that never has fp state. with it the console task touches the fpu first, so CONTROL.FPCA is
+// set and the switch has to stack/restore s16-s31 as well. 0 if the bench task couldn't start
+static uint32_t UART_YieldCycles(uint8_t withFp)
+{
+    if (!withFp) {
+        benchYieldCyc = 0;
+        if (xTaskCreate(UART_YieldBenchTask, "YieldBench", configMINIMAL_STACK_SIZE, NULL,
+                        uxTaskPriorityGet(NULL) + 1, NULL) != pdPASS) {
+            return 0;
+        }
+        return benchYieldCyc;
+    }
+
+#if (__FPU_USED == 1)
+    __asm volatile ("vmov.f32 s0, s0" ::: "s0");
+#endif
+    return UART_YieldLoop() / BENCH_YIELDS;
+}
+
+static void UART_HandleCommand(const char *cmd)
+{
+    const char *arg;
+    char buf[64];
+
+    // reprint what user typed
+    print_str("\r\nCommand received: ");
+    print_str((char *)cmd);
+    print_str("\r\n");
+
+    // check what was input to see if it aligns with our modes
+    if (stricmp(cmd, "manual") == 0)
+    {
+        ControlTask_SetMode(MODE_MANUAL);
+        print_str("Manual mode selected\r\n");
+    }
+    else if (stricmp(cmd, "auto") == 0)
+    {
+        ControlTask_SetMode(MODE_AUTO);
+        print_str("Auto mode selected\r\n");
+    }
+    else if (stricmp(cmd, "cal") == 0)
+    {
+        ControlTask_SetMode(MODE_CAL);
+        print_str("Calibration mode selected\r\n");
+    }
+    // telemetry stream rate, "telem off" or "telem <10-200>"
+    else if (UART_MatchCommand(cmd, "telem", &arg))
+    {
+        if (stricmp(arg, "off") == 0) {
+            Telemetry_SetRate(0);
+        } else if (*arg != '\0') {
+            char *end;
+            unsigned long hz = strtoul(arg, &end, 10);
+            while (*end == ' ') end++;
+            if (end == arg || *end != '\0') {
+                print_str("Usage: telem <10-200>|off\r\n");
+                return;
             }
-            else
-            {
-                // if enter was not pressed, push the char into the command buffer
-                if (cmdIndex < sizeof(uartCommand) - 1)
-                {
-                    uartCommand[cmdIndex++] = ch;
-                }
+            Telemetry_SetRate(hz > TELEMETRY_MAX_HZ ? TELEMETRY_MAX_HZ : (uint16_t)hz);
+        }
+        snprintf(buf, sizeof(buf), "Telemetry: %u Hz\r\n", Telemetry_GetRate());
+        print_str(buf);
+    }
+    // console baud rate, the host has to follow (e.g. "baud 921600")
+    else if (UART_MatchCommand(cmd, "baud", &arg) && *arg != '\0')
+    {
+        uint32_t baud = strtoul(arg, NULL, 10);
+        if (baud < 9600 || baud > 921600) {
+            print_str("Baud must be 9600-921600\r\n");
+        } else {
+            snprintf(buf, sizeof(buf), "Switching to %lu baud\r\n", (unsigned long)baud);
+            print_str(buf);
+            if (!util_set_baud(baud)) {
+                print_str("Baud change failed, output did not drain\r\n");
             }
         }
     }
+    // log thresholds, "log" lists them, "log <level>" sets all, "log <module> <level>" sets one
+    else if (UART_MatchCommand(cmd, "log", &arg))
+    {
+        UART_LogCommand(arg, buf, sizeof(buf));
+    }
+    // cpu use per task since the last "tasks"
+    else if (stricmp(cmd, "tasks") == 0)
+    {
+        UART_TasksCommand(buf, sizeof(buf));
+    }
+    // latest range sample and what the filter costs per sample
+    else if (stricmp(cmd, "sensor") == 0)
+    {
+        CraneSensorData s = {0};
+        uint32_t last, max;
+
+        SensorTask_GetLatest(&s);
+        SensorTask_GetFilterCycles(&last, &max);
+
+        static const char *const statusNames[] = { "ok", "no echo", "out of range" };
+        const char *status = s.status < sizeof(statusNames) / sizeof(statusNames[0]) ? statusNames[s.status] : "?";
+
+        // um to hundredths of a cm
+        int32_t raw = s.heightUm / 100;
+        int32_t filt = s.heightFiltUm / 100;
+        int32_t vel = s.velocityUmS / 100;
+        if (s.heightUm == SENSOR_HEIGHT_INVALID) {
+            snprintf(buf, sizeof(buf), "Raw --  ");
+        } else {
+            snprintf(buf, sizeof(buf), "Raw %ld.%02ld cm  ", (long)(raw / 100), (long)(raw % 100));
+        }
+        print_str(buf);
+        if (s.heightFiltUm == SENSOR_HEIGHT_INVALID) {
+            snprintf(buf, sizeof(buf), "filt --  %s\r\n", status);
+        } else {
+            snprintf(buf, sizeof(buf), "filt %ld.%02ld cm  %s\r\n", (long)(filt / 100), (long)(filt % 100), status);
+        }
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Vel %s%ld.%02ld cm/s  filter %lu cyc (max %lu)\r\n",
+                 vel < 0 ? "-" : "", (long)(labs(vel) / 100), (long)(labs(vel) % 100),
+                 (unsigned long)last, (unsigned long)max);
+        print_str(buf);
+
+        SensorHealth h;
+        SensorTask_GetHealth(&h);
+        snprintf(buf, sizeof(buf), "Ping %ums  %u Hz  echoes %lu  timeouts %lu\r\n",
+                 h.periodMs, h.achievedHz, (unsigned long)h.echoes, (unsigned long)h.timeouts);
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Out of range %lu  outliers %lu  lat %lu us (max %lu)\r\n",
+                 (unsigned long)h.outOfRange, (unsigned long)h.outliers,
+                 (unsigned long)h.latencyLastUs, (unsigned long)h.latencyMaxUs);
+        print_str(buf);
+
+        snprintf(buf, sizeof(buf), "Predict err %ld um (max %lu)\r\n",
+                 (long)h.predictErrUm, (unsigned long)h.predictErrMaxUm);
+        print_str(buf);
+
+        // histogram, bucket i is under (1 << i) ms, the last one is everything above
+        print_str("Latency");
+        for (uint8_t i = 0; i < SENSOR_LAT_BUCKETS; i++)
+        {
+            uint8_t lastBucket = (i == SENSOR_LAT_BUCKETS - 1);
+            snprintf(buf, sizeof(buf), "  %s%ums %lu", lastBucket ? ">=" : "<",
+                     lastBucket ? (1U << (i - 1)) : (1U << i), (unsigned long)h.latencyHist[i]);
+            print_str(buf);
+        }
+        print_str("\r\n");
+    }
+    // input edge latency: to the event being queued, and to ControlTask acting on it
+    else if (stricmp(cmd, "input") == 0)
+    {
+        uint32_t postLast, postMax, events, handledLast, handledMax;
+
+        InputTask_GetLatency(&postLast, &postMax, &events);
+        ControlTask_GetInputLatency(&handledLast, &handledMax);
+        snprintf(buf, sizeof(buf), "Input events %lu  dropped %lu  levels 0x%02x\r\n", (unsigned long)events,
+                 (unsigned long)InputTask_GetDropped(), InputTask_GetSnapshot());
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Edge->queued %lu us (max %lu)\r\n",
+                 (unsigned long)postLast, (unsigned long)postMax);
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Edge->handled %lu us (max %lu)\r\n",
+                 (unsigned long)handledLast, (unsigned long)handledMax);
+        print_str(buf);
+
+        uint32_t stopLast, stopMax, stops;
+        Crane_GetLimitStopLatency(&stopLast, &stopMax, &stops);
+        snprintf(buf, sizeof(buf), "Limit stops %lu, edge->CCR %lu cyc (max %lu)\r\n",
+                 (unsigned long)stops, (unsigned long)stopLast, (unsigned long)stopMax);
+        print_str(buf);
+    }
+    // what wakes ControlTask and how often, "wake reset" starts counting again
+    else if (UART_MatchCommand(cmd, "wake", &arg))
+    {
+        ControlWakeStats w;
+        uint32_t cycPerUs = SystemCoreClock / 1000000;
+
+        if (stricmp(arg, "reset") == 0) {
+            ControlTask_ResetWakeStats();
+            print_str("Wake counts cleared\r\n");
+            return;
+        }
+
+        ControlTask_GetWakeStats(&w);
+        uint32_t ms = (xTaskGetTickCount() - w.sinceTick) * portTICK_PERIOD_MS;
+        uint32_t perSec100 = ms ? (uint32_t)(((uint64_t)w.passes * 100000) / ms) : 0;
+        snprintf(buf, sizeof(buf), "Passes %lu in %lu ms, %lu.%02lu/s (polling was 50/s)\r\n",
+                 (unsigned long)w.passes, (unsigned long)ms, (unsigned long)(perSec100 / 100),
+                 (unsigned long)(perSec100 % 100));
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Input %lu  sensor %lu  mode %lu\r\n", (unsigned long)w.input,
+                 (unsigned long)w.sensor, (unsigned long)w.mode);
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Deadline %lu  watchdog (idle) %lu\r\n", (unsigned long)w.deadline,
+                 (unsigned long)w.watchdog);
+        print_str(buf);
+        snprintf(buf, sizeof(buf), "Sample->control %lu us (max %lu)\r\n", (unsigned long)(w.sensorLatLastCyc / cycPerUs),
+                 (unsigned long)(w.sensorLatMaxCyc / cycPerUs));
+        print_str(buf);
+    }
+    // vertical controller: "pid" lists it, "pid gains <kp> <ki> <kd>" retunes (x1000),
+    // "pid <step> profile|pid|bang" picks the controller an auto step uses
+    else if (UART_MatchCommand(cmd, "pid", &arg))
+    {
+        UART_PidCommand(arg, buf, sizeof(buf));
+    }
+    // auto sequence table upload and run times
+    else if (UART_MatchCommand(cmd, "seq", &arg))
+    {
+        UART_SeqCommand(arg, buf, sizeof(buf));
+    }
+    // float vs integer sensor path, and what a context switch costs with and without fp state
+    else if (stricmp(cmd, "bench") == 0)
+    {
+        uint32_t floatCyc, fixedCyc;
+
+        SensorTask_Bench(BENCH_SAMPLES, &floatCyc, &fixedCyc);
+        snprintf(buf, sizeof(buf), "Convert+filter: float %lu cyc, int %lu cyc per sample\r\n",
+                 (unsigned long)floatCyc, (unsigned long)fixedCyc);
+        print_str(buf);
+
+        uint32_t plain = UART_YieldCycles(0);
+        uint32_t fp = UART_YieldCycles(1);
+        snprintf(buf, sizeof(buf), "Yield: %lu cyc without fp context, %lu cyc with\r\n",
+                 (unsigned long)plain, (unsigned long)fp);
+        print_str(buf);
+    }
+    // if input not aligned with modes, print error msg
+    else
+    {
+        print_str("Unknown command\r\n");
+    }
+}
+
+static void UART_CommandTask(void *param)
+{
+    uint32_t droppedReported = 0;
+
+    print_str("UART: Type 'manual', 'auto', 'cal', 'telem <hz|off>', 'baud <rate>', 'log [module] <level>', 'tasks', 'sensor', 'input', 'wake', 'pid', 'seq' or 'bench'\r\n"); // print input options to user
+
+    UART_StartReceive();
+
+    while (1)
+    {
+        // sleep until the rx isr hands over a complete line
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (commandsDropped != droppedReported)
+        {
+            droppedReported = commandsDropped;
+            LOG_WARN(UART, "%lu console lines dropped while busy", droppedReported);
+        }
+
+        if (commandReady)
+        {
+            UART_HandleCommand(uartCommand);
+
+            // reset the buffer and let the isr deliver the next line
+            memset(uartCommand, 0, sizeof(uartCommand));
+            commandReady = 0;
+        }
+    }
 }
 
 void UART_StartCommandTask(void)
@@ -8,32 +8,175 @@
 #include <string.h>
 
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "task.h"
+#include "timers.h"
+
+#include "User/util.h"
+
+// size of the uart transmit ring, must be a power of two
+#define TX_RING_SIZE	1024
+#define TX_RING_MASK	(TX_RING_SIZE - 1)
+#define TX_RETRY_MS		1		// a dma start that failed is tried again this much later
 
-static SemaphoreHandle_t mutexHandle_print_str;
 extern UART_HandleTypeDef huart2;
 
+// transmit ring drained by usart2 tx dma (head/tail are free running, masked on access)
+static uint8_t txRing[TX_RING_SIZE];
+static volatile uint32_t txHead = 0;		// next byte written by callers
+static volatile uint32_t txTail = 0;		// next byte to be sent by dma
+static volatile uint16_t txInFlight = 0;	// length of the dma transfer in progress
+
+// overflow counter (messages that did not fit are dropped whole, never blocked on)
+static volatile uint32_t txDroppedMsgs = 0;
+
+// restarts the dma when starting it failed, nothing else would until the next write
+static TimerHandle_t txRetryTimer = NULL;
+
+static void tx_retry(TimerHandle_t timer);
+
 void util_init(){
-	mutexHandle_print_str = xSemaphoreCreateMutex();
+	txHead = 0;
+	txTail = 0;
+	txInFlight = 0;
+	txDroppedMsgs = 0;
+	txRetryTimer = xTimerCreate("TxRetry", pdMS_TO_TICKS(TX_RETRY_MS), pdFALSE, NULL, tx_retry);
+}
+
+// start dma on the next contiguous chunk of the ring (caller must hold the critical section)
+static void tx_kick(void){
+	if (txInFlight != 0 || txHead == txTail) {
+		return; // already sending or nothing to send
+	}
+
+	uint32_t start = txTail & TX_RING_MASK;
+	uint32_t len = txHead - txTail;
+
+	// dma can't wrap, so stop at the end of the ring and chain the rest from the complete callback
+	if (len > TX_RING_SIZE - start) {
+		len = TX_RING_SIZE - start;
+	}
+
+	txInFlight = (uint16_t)len;
+	if (HAL_UART_Transmit_DMA(&huart2, &txRing[start], (uint16_t)len) != HAL_OK) {
+		txInFlight = 0;
+
+		// uart or dma still busy, try again shortly. the timer restarting is harmless
+		if (txRetryTimer == NULL) {
+			return;
+		}
+		if (xPortIsInsideInterrupt()) {
+			BaseType_t woken = pdFALSE;
+			xTimerStartFromISR(txRetryTimer, &woken);
+			portYIELD_FROM_ISR(woken);
+		} else {
+			xTimerStart(txRetryTimer, 0);
+		}
+	}
 }
 
-static void print_str_local(char * str){
-	HAL_UART_Transmit(&huart2,(uint8_t*) str, strlen(str), HAL_MAX_DELAY);
+// timer task context
+static void tx_retry(TimerHandle_t timer){
+	(void)timer;
+
+	taskENTER_CRITICAL();
+	tx_kick();
+	taskEXIT_CRITICAL();
 }
 
+// copy bytes into the ring (caller must hold the critical section)
+static uint16_t tx_write(const uint8_t *data, uint16_t len){
+	uint32_t free = TX_RING_SIZE - (txHead - txTail);
+
+	if (len > free) {
+		txDroppedMsgs++;
+		return 0;
+	}
+
+	uint32_t start = txHead & TX_RING_MASK;
+	uint32_t first = TX_RING_SIZE - start;
+
+	if (first >= len) {
+		memcpy(&txRing[start], data, len);
+	} else {
+		memcpy(&txRing[start], data, first);
+		memcpy(&txRing[0], data + first, len - first);
+	}
+
+	txHead += len;
+	tx_kick();
+
+	return len;
+}
+
+// usart2 transmit complete, release the sent chunk and chain the next one
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	if (huart->Instance != USART2) {
+		return;
+	}
+
+	UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+	txTail += txInFlight;
+	txInFlight = 0;
+	tx_kick();
+	taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+// usart2 error callback (uart.c). a dma error aborts the transmit without a complete callback,
+// so release what went out before it and send the rest
+void util_tx_error(void){
+	UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+	if (txInFlight != 0 && huart2.gState == HAL_UART_STATE_READY) {
+		txTail += txInFlight - __HAL_DMA_GET_COUNTER(huart2.hdmatx);
+		txInFlight = 0;
+	}
+	tx_kick();
+	taskEXIT_CRITICAL_FROM_ISR(saved);
+}
 
 void print_str(char * str){
-	xSemaphoreTake(mutexHandle_print_str, portMAX_DELAY);
-	print_str_local(str);
-	xSemaphoreGive(mutexHandle_print_str);
+	uint16_t len = strlen(str);
+
+	taskENTER_CRITICAL();
+	tx_write((const uint8_t *)str, len);
+	taskEXIT_CRITICAL();
 }
+
 void print_str_ISR(char * str){
-	print_str_local(str);
+	uint16_t len = strlen(str);
+
+	UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+	tx_write((const uint8_t *)str, len);
+	taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+uint16_t print_bytes(const uint8_t *data, uint16_t len){
+	uint16_t written;
+
+	taskENTER_CRITICAL();
+	written = tx_write(data, len);
+	taskEXIT_CRITICAL();
+
+	return written;
 }
 
-void print_str_unsafe(char * str){
-	for(int i =0; i<strlen(str);i++){
-		HAL_UART_Transmit(&huart2,(uint8_t*) &str[i], 1, HAL_MAX_DELAY);
-		for(int j=0;j<100000;j++);
+uint8_t util_set_baud(uint32_t baud){
+	// let everything queued at the old rate go out first (bounded so a stuck uart can't hang us)
+	for (int i = 0; i < 100 && txHead != txTail; i++) {
+		vTaskDelay(pdMS_TO_TICKS(10));
 	}
+	if (txHead != txTail) {
+		return 0;
+	}
+
+	// only the divider changes, rx dma and the idle line interrupt keep running
+	taskENTER_CRITICAL();
+	huart2.Init.BaudRate = baud;
+	huart2.Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), baud);
+	taskEXIT_CRITICAL();
+
+	return 1;
+}
+
+uint32_t print_get_dropped(void){
+	return txDroppedMsgs;
 }
@@ -52,6 +52,51 @@
 
 /* USER CODE END FunctionPrototypes */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+
+#define RUN_TIME_STATS_HZ	100000U		// 10us resolution, 100x the tick, wraps after ~12h
+
+static uint32_t runTimeLastCycles = 0;
+static uint32_t runTimeCycleRem = 0;
+static uint32_t runTimeCount = 0;
+
+void configureTimerForRunTimeStats(void)
+{
+  // free running core cycle counter, no timer or interrupt needed
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  runTimeLastCycles = 0;
+  runTimeCycleRem = 0;
+  runTimeCount = 0;
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  // CYCCNT wraps every ~51s at 84MHz, so accumulate deltas (called at every context switch)
+  // into a slower count. called from pendsv and from tasks, so keep it atomic with primask.
+  uint32_t primask = __get_PRIMASK();
+  uint32_t cyclesPerCount = SystemCoreClock / RUN_TIME_STATS_HZ;
+  uint32_t now;
+
+  __disable_irq();
+  now = DWT->CYCCNT;
+  runTimeCycleRem += now - runTimeLastCycles;
+  runTimeLastCycles = now;
+  runTimeCount += runTimeCycleRem / cyclesPerCount;
+  runTimeCycleRem %= cyclesPerCount;
+  __set_PRIMASK(primask);
+
+  return runTimeCount;
+}
+/* USER CODE END 1 */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
@@ -0,0 +1,470 @@
+// crane_recorder.cpp
+//
+// Records the firmware's binary telemetry stream ("telem <hz>" on the console).
+// Reads a serial device, pty or capture file, resynchronises on frame delimiters,
+// checks CRCs and writes CSV or a columnar directory (one little endian .bin per
+// column plus schema.json), then reports drop and CRC statistics.
+//
+// A generator mode fakes the crane's stream on a pseudo-terminal and a bench mode
+// times the decoder on an in-memory stream, so neither needs a board attached.
+//
+//   crane_recorder -b 921600 -o run.csv /dev/ttyACM0
+//   crane_recorder -c run_cols/ capture.bin
+//   crane_recorder --generate --rate 200 --seconds 10      (prints the pty to record from)
+//   crane_recorder --bench --mb 64
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "link_codec.hpp"
+#include "serial_port.hpp"
+#include "telemetry_frame.hpp"
+
+namespace {
+
+std::atomic<bool> g_stop {false};
+
+void on_signal(int) { g_stop = true; }
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// ---------------------------------------
+// output writers
+// ---------------------------------------
+
+class Writer {
+public:
+    virtual ~Writer() = default;
+    virtual void write(const telemetry::Frame &f) = 0;
+    virtual void close() {}
+};
+
+class CsvWriter : public Writer {
+public:
+    explicit CsvWriter(const std::string &path) : out_(path)
+    {
+        if (!out_)
+            throw std::runtime_error("cannot write " + path);
+        const auto &cols = telemetry::columns();
+        for (size_t i = 0; i < cols.size(); i++)
+            out_ << (i ? "," : "") << cols[i].name;
+        out_ << '\n';
+    }
+
+    void write(const telemetry::Frame &f) override
+    {
+        const auto &cols = telemetry::columns();
+        char buf[32];
+        for (size_t i = 0; i < cols.size(); i++) {
+            double v = cols[i].get(f);
+            if (std::isnan(v))
+                buf[0] = '\0';
+            else if (cols[i].type == telemetry::ColType::F32)
+                std::snprintf(buf, sizeof(buf), "%.4f", v);
+            else
+                std::snprintf(buf, sizeof(buf), "%.0f", v);
+            out_ << (i ? "," : "") << buf;
+        }
+        out_ << '\n';
+    }
+
+private:
+    std::ofstream out_;
+};
+
+// parquet-style layout without the dependency: each column is stored contiguously in its
+// own file so a single signal can be loaded without touching the rest (numpy.fromfile etc.)
+class ColumnarWriter : public Writer {
+public:
+    explicit ColumnarWriter(const std::string &dir) : dir_(dir)
+    {
+        ::mkdir(dir.c_str(), 0755);
+        for (const auto &c : telemetry::columns()) {
+            files_.emplace_back(new std::ofstream(dir + "/" + c.name + ".bin", std::ios::binary));
+            if (!*files_.back())
+                throw std::runtime_error("cannot write into " + dir);
+        }
+    }
+
+    void write(const telemetry::Frame &f) override
+    {
+        const auto &cols = telemetry::columns();
+        for (size_t i = 0; i < cols.size(); i++) {
+            double v = cols[i].get(f);
+            switch (cols[i].type) {
+            case telemetry::ColType::U8: put<uint8_t>(i, static_cast<uint8_t>(v)); break;
+            case telemetry::ColType::U16: put<uint16_t>(i, static_cast<uint16_t>(v)); break;
+            case telemetry::ColType::U32: put<uint32_t>(i, static_cast<uint32_t>(v)); break;
+            case telemetry::ColType::F32: put<float>(i, static_cast<float>(v)); break;
+            }
+        }
+        rows_++;
+    }
+
+    void close() override
+    {
+        static const char *type_names[] = {"uint8", "uint16", "uint32", "float32"};
+        std::ofstream schema(dir_ + "/schema.json");
+        schema << "{\n  \"rows\": " << rows_ << ",\n  \"endian\": \"little\",\n  \"columns\": [\n";
+        const auto &cols = telemetry::columns();
+        for (size_t i = 0; i < cols.size(); i++) {
+            files_[i]->close();
+            schema << "    {\"name\": \"" << cols[i].name << "\", \"type\": \""
+                   << type_names[static_cast<int>(cols[i].type)] << "\", \"file\": \"" << cols[i].name
+                   << ".bin\"}" << (i + 1 < cols.size() ? "," : "") << "\n";
+        }
+        schema << "  ]\n}\n";
+    }
+
+private:
+    template <typename T>
+    void put(size_t col, T v)
+    {
+        files_[col]->write(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    std::string dir_;
+    std::vector<std::unique_ptr<std::ofstream>> files_;
+    uint64_t rows_ = 0;
+};
+
+// ---------------------------------------
+// stream statistics on top of the link decoder
+// ---------------------------------------
+
+struct RecordStats {
+    uint64_t telemetry = 0;
+    uint64_t other_frames = 0;
+    uint64_t bad_length = 0;
+    uint64_t dropped = 0;       // gaps in the frame sequence counter
+    bool have_seq = false;
+    uint16_t last_seq = 0;
+
+    void on_frame(const telemetry::Frame &f)
+    {
+        if (have_seq)
+            dropped += static_cast<uint16_t>(f.seq - last_seq - 1);
+        have_seq = true;
+        last_seq = f.seq;
+        telemetry++;
+    }
+};
+
+void print_stats(const cranelink::Stats &ls, const RecordStats &rs, double secs)
+{
+    double mb = ls.bytes / 1e6;
+    std::fprintf(stderr,
+                 "bytes %llu  telemetry frames %llu  other frames %llu  dropped %llu  "
+                 "crc errors %llu  cobs errors %llu  bad length %llu  text bytes %llu\n",
+                 static_cast<unsigned long long>(ls.bytes), static_cast<unsigned long long>(rs.telemetry),
+                 static_cast<unsigned long long>(rs.other_frames), static_cast<unsigned long long>(rs.dropped),
+                 static_cast<unsigned long long>(ls.crc_errors), static_cast<unsigned long long>(ls.cobs_errors),
+                 static_cast<unsigned long long>(rs.bad_length), static_cast<unsigned long long>(ls.text_bytes));
+    if (secs > 0)
+        std::fprintf(stderr, "%.3f s  %.2f MB/s  %.0f frames/s\n", secs, mb / secs, ls.frames / secs);
+}
+
+// ---------------------------------------
+// synthetic crane stream
+// ---------------------------------------
+
+class Generator {
+public:
+    Generator(double corrupt, double drop, uint32_t seed) : corrupt_(corrupt), drop_(drop), rng_(seed) {}
+
+    // appends the bytes for one 200 Hz step of fake crane motion
+    void next(std::vector<uint8_t> &out)
+    {
+        telemetry::Frame f {};
+        double t = tick_ / 1000.0;
+        f.seq = seq_++;
+        f.tick = tick_;
+        double cm = 8.5 + 6.5 * std::sin(t * 0.4);
+        f.height_um = static_cast<int32_t>(cm * telemetry::kUmPerCm);
+        f.height_norm = static_cast<uint16_t>((cm - 1.0) / 19.0 * telemetry::kNormOne);
+        f.mode = static_cast<uint8_t>((tick_ / 30000) % 3);
+        f.auto_step = static_cast<uint8_t>((tick_ / 3000) % 10);
+        double v = std::cos(t * 0.4);
+        f.ccr1 = static_cast<uint16_t>(v > 0.1 ? 1440 : v < -0.1 ? 1570 : 1500);
+        f.ccr2 = static_cast<uint16_t>(f.auto_step % 2 ? 1570 : 1500);
+        f.control_queue = static_cast<uint8_t>(rng_() % 3);
+        f.servo_queue = static_cast<uint8_t>(rng_() % 2);
+        f.height_filt_um = f.height_um;
+        f.velocity_um_s = static_cast<int32_t>(6.5 * 0.4 * v * telemetry::kUmPerCm);
+        // every 50th ping lost, the odd one out of range
+        f.sensor_status = static_cast<uint8_t>(f.seq % 50 == 0 ? 1 : f.seq % 333 == 0 ? 2 : 0);
+        if (f.sensor_status == 1)
+            f.height_um = telemetry::kHeightInvalid;
+        timeouts_ += f.sensor_status == 1;
+        out_of_range_ += f.sensor_status == 2;
+        f.echo_timeouts = timeouts_;
+        f.out_of_range = out_of_range_;
+        f.outliers = static_cast<uint16_t>(f.seq / 97);
+        f.sample_hz = 40;
+        f.latency_us = static_cast<uint16_t>(900 + rng_() % 400);
+        tick_ += 5;
+
+        // the firmware interleaves console text between frames
+        if (f.seq % 64 == 0) {
+            static const char line[] = "Crane: MOVING VERTICAL UP\r\n";
+            out.insert(out.end(), line, line + sizeof(line) - 1);
+        }
+
+        if (uni_(rng_) < drop_)
+            return; // frame lost, the seq gap shows up in the recorder
+
+        auto payload = telemetry::serialize(f);
+        auto frame = cranelink::encode_frame(cranelink::FRAME_TELEMETRY, payload.data(), payload.size());
+        if (uni_(rng_) < corrupt_)
+            frame[1 + rng_() % (frame.size() - 2)] ^= static_cast<uint8_t>(1 + rng_() % 255);
+        out.insert(out.end(), frame.begin(), frame.end());
+    }
+
+private:
+    double corrupt_, drop_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uni_ {0.0, 1.0};
+    uint16_t seq_ = 0;
+    uint32_t tick_ = 0;
+    uint16_t timeouts_ = 0;
+    uint16_t out_of_range_ = 0;
+};
+
+int run_generate(double rate, double seconds, double corrupt, double drop)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+        throw std::runtime_error("cannot allocate a pty");
+    const char *slave_name = ptsname(master);
+
+    // keep the slave open and raw so nothing is echoed or translated before a reader attaches
+    int slave = ::open(slave_name, O_RDWR | O_NOCTTY);
+    if (slave < 0)
+        throw std::runtime_error(std::string("cannot open ") + slave_name);
+    serial::make_raw(slave, 115200);
+
+    std::printf("%s\n", slave_name);
+    std::fflush(stdout);
+    std::fprintf(stderr, "generating on %s at %s, ctrl-c to stop\n", slave_name,
+                 rate > 0 ? (std::to_string(static_cast<int>(rate)) + " Hz").c_str() : "full speed");
+
+    Generator gen(corrupt, drop, 1);
+    std::vector<uint8_t> buf;
+    uint64_t frames = 0, bytes = 0;
+    auto t0 = Clock::now();
+    timespec next {};
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!g_stop && (seconds <= 0 || seconds_since(t0) < seconds)) {
+        buf.clear();
+        // paced: one frame per period; full speed: batches big enough to keep the pty busy
+        int batch = rate > 0 ? 1 : 256;
+        for (int i = 0; i < batch; i++)
+            gen.next(buf);
+        frames += batch;
+
+        size_t off = 0;
+        while (off < buf.size() && !g_stop) {
+            ssize_t n = ::write(master, buf.data() + off, buf.size() - off);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("pty write failed");
+            }
+            off += static_cast<size_t>(n);
+        }
+        bytes += buf.size();
+
+        if (rate > 0) {
+            long period_ns = static_cast<long>(1e9 / rate);
+            next.tv_nsec += period_ns;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    }
+
+    double secs = seconds_since(t0);
+    std::fprintf(stderr, "sent %llu frames, %llu bytes in %.3f s (%.2f MB/s)\n",
+                 static_cast<unsigned long long>(frames), static_cast<unsigned long long>(bytes), secs,
+                 bytes / 1e6 / secs);
+    ::close(slave);
+    ::close(master);
+    return 0;
+}
+
+int run_bench(double mb, double corrupt, double drop)
+{
+    Generator gen(corrupt, drop, 2);
+    std::vector<uint8_t> stream;
+    stream.reserve(static_cast<size_t>(mb * 1e6) + 4096);
+    while (stream.size() < mb * 1e6)
+        gen.next(stream);
+
+    RecordStats rs;
+    double height_sum = 0;
+    cranelink::Decoder dec(
+        [&](uint8_t type, const uint8_t *p, size_t len) {
+            telemetry::Frame f;
+            if (type == cranelink::FRAME_TELEMETRY && telemetry::parse(p, len, f)) {
+                rs.on_frame(f);
+                if (f.height_um != telemetry::kHeightInvalid)
+                    height_sum += telemetry::height_cm(f.height_um);
+            }
+        },
+        nullptr);
+
+    // same 4 KB reads the recorder does on a real port
+    auto t0 = Clock::now();
+    for (size_t off = 0; off < stream.size(); off += 4096)
+        dec.feed(stream.data() + off, std::min<size_t>(4096, stream.size() - off));
+    double secs = seconds_since(t0);
+
+    print_stats(dec.stats(), rs, secs);
+    std::fprintf(stderr, "(checksum %.1f)\n", height_sum);
+    return 0;
+}
+
+int run_record(const std::string &input, unsigned baud, Writer *writer, uint64_t max_frames, double seconds)
+{
+    RecordStats rs;
+    cranelink::Decoder dec(
+        [&](uint8_t type, const uint8_t *p, size_t len) {
+            if (type != cranelink::FRAME_TELEMETRY) {
+                rs.other_frames++;
+                return;
+            }
+            telemetry::Frame f;
+            if (!telemetry::parse(p, len, f)) {
+                rs.bad_length++;
+                return;
+            }
+            rs.on_frame(f);
+            if (writer)
+                writer->write(f);
+            if (max_frames && rs.telemetry >= max_frames)
+                g_stop = true;
+        },
+        nullptr);
+
+    int fd = serial::open_input(input, baud);
+    uint8_t buf[4096];
+    auto t0 = Clock::now();
+
+    while (!g_stop && (seconds <= 0 || seconds_since(t0) < seconds)) {
+        pollfd pfd {fd, POLLIN, 0};
+        int r = ::poll(&pfd, 1, 200);
+        if (r < 0 && errno != EINTR)
+            break;
+        if (r <= 0)
+            continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        dec.feed(buf, static_cast<size_t>(n));
+    }
+
+    if (writer)
+        writer->close();
+    print_stats(dec.stats(), rs, seconds_since(t0));
+    if (fd != STDIN_FILENO)
+        ::close(fd);
+    return 0;
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: crane_recorder [-b baud] [-o out.csv | -c outdir] [-n frames] [-t seconds] input\n"
+                 "       crane_recorder --generate [--rate hz] [--seconds s] [--corrupt p] [--drop p]\n"
+                 "       crane_recorder --bench [--mb n] [--corrupt p] [--drop p]\n"
+                 "  input       serial device, pty, capture file or - for stdin\n"
+                 "  -o          write csv\n"
+                 "  -c          write one binary file per column plus schema.json\n"
+                 "  --rate      generator frames per second, 0 = as fast as the pty takes them (default 200)\n"
+                 "  --corrupt   probability of flipping a byte in a frame (default 0)\n"
+                 "  --drop      probability of leaving a frame out (default 0)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string input, csv_path, col_dir;
+    unsigned baud = 115200;
+    uint64_t max_frames = 0;
+    double seconds = 0, rate = 200, mb = 32, corrupt = 0, drop = 0;
+    bool generate = false, bench = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "-b") baud = static_cast<unsigned>(std::stoul(next()));
+        else if (a == "-o") csv_path = next();
+        else if (a == "-c") col_dir = next();
+        else if (a == "-n") max_frames = std::stoull(next());
+        else if (a == "-t" || a == "--seconds") seconds = std::stod(next());
+        else if (a == "--generate") generate = true;
+        else if (a == "--bench") bench = true;
+        else if (a == "--rate") rate = std::stod(next());
+        else if (a == "--mb") mb = std::stod(next());
+        else if (a == "--corrupt") corrupt = std::stod(next());
+        else if (a == "--drop") drop = std::stod(next());
+        else if (a == "-h" || a == "--help") { usage(); return 0; }
+        else input = a;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    try {
+        if (generate)
+            return run_generate(rate, seconds, corrupt, drop);
+        if (bench)
+            return run_bench(mb, corrupt, drop);
+        if (input.empty() || (!csv_path.empty() && !col_dir.empty())) {
+            usage();
+            return 2;
+        }
+
+        std::unique_ptr<Writer> writer;
+        if (!csv_path.empty())
+            writer.reset(new CsvWriter(csv_path));
+        else if (!col_dir.empty())
+            writer.reset(new ColumnarWriter(col_dir));
+        return run_record(input, baud, writer.get(), max_frames, seconds);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "crane_recorder: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,324 @@
+// crane_trace.cpp
+//
+// Decodes the firmware's tokenized TRACE() records back into text.
+// Format strings come from the .trace_fmt section of the firmware ELF, or from a
+// table previously dumped from it, so the decoder does not need the source tree.
+//
+//   crane_trace -e Debug/rts-crane-project.elf /dev/ttyACM0
+//   crane_trace -e Debug/rts-crane-project.elf --dump-table fmt.tsv
+//   crane_trace -t fmt.tsv capture.bin
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "link_codec.hpp"
+#include "serial_port.hpp"
+
+namespace {
+
+using FormatTable = std::map<uint16_t, std::string>;
+
+// ---------------------------------------
+// format table sources
+// ---------------------------------------
+
+template <typename T>
+T rd(const std::vector<uint8_t> &buf, size_t off)
+{
+    if (off + sizeof(T) > buf.size())
+        throw std::runtime_error("truncated ELF");
+    T v;
+    std::memcpy(&v, &buf[off], sizeof(T));
+    return v;
+}
+
+// reads .trace_fmt from a little endian ELF32 (firmware) or ELF64 (host test build)
+FormatTable load_elf(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        throw std::runtime_error("cannot open " + path);
+    std::vector<uint8_t> elf((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    if (elf.size() < 64 || std::memcmp(elf.data(), "\x7f" "ELF", 4) != 0)
+        throw std::runtime_error(path + " is not an ELF file");
+    bool is64 = elf[4] == 2;
+    if (elf[5] != 1)
+        throw std::runtime_error(path + " is not little endian");
+
+    uint64_t shoff = is64 ? rd<uint64_t>(elf, 0x28) : rd<uint32_t>(elf, 0x20);
+    uint16_t shentsize = rd<uint16_t>(elf, is64 ? 0x3A : 0x2E);
+    uint16_t shnum = rd<uint16_t>(elf, is64 ? 0x3C : 0x30);
+    uint16_t shstrndx = rd<uint16_t>(elf, is64 ? 0x3E : 0x32);
+
+    auto sh = [&](uint16_t idx, uint32_t &name, uint64_t &addr, uint64_t &off, uint64_t &size) {
+        size_t base = shoff + static_cast<size_t>(idx) * shentsize;
+        name = rd<uint32_t>(elf, base);
+        addr = is64 ? rd<uint64_t>(elf, base + 0x10) : rd<uint32_t>(elf, base + 0x0C);
+        off = is64 ? rd<uint64_t>(elf, base + 0x18) : rd<uint32_t>(elf, base + 0x10);
+        size = is64 ? rd<uint64_t>(elf, base + 0x20) : rd<uint32_t>(elf, base + 0x14);
+    };
+
+    uint32_t name;
+    uint64_t addr, off, size;
+    sh(shstrndx, name, addr, off, size);
+    uint64_t strtab = off;
+
+    for (uint16_t i = 0; i < shnum; i++) {
+        sh(i, name, addr, off, size);
+        if (strtab + name >= elf.size())
+            continue;
+        if (std::strcmp(reinterpret_cast<const char *>(&elf[strtab + name]), ".trace_fmt") != 0)
+            continue;
+        if (off + size > elf.size())
+            throw std::runtime_error(".trace_fmt runs past the end of " + path);
+
+        // ids are the low 16 bits of each string's address, the firmware links the section at 0
+        FormatTable table;
+        size_t start = 0;
+        for (size_t k = 0; k < size; k++) {
+            if (elf[off + k] != 0)
+                continue;
+            if (k > start) {
+                uint16_t id = static_cast<uint16_t>(addr + start);
+                table[id] = std::string(reinterpret_cast<const char *>(&elf[off + start]), k - start);
+            }
+            start = k + 1;
+        }
+        return table;
+    }
+    throw std::runtime_error(path + " has no .trace_fmt section");
+}
+
+std::string escape(const std::string &s)
+{
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default: out += c;
+        }
+    }
+    return out;
+}
+
+std::string unescape(const std::string &s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] != '\\' || i + 1 == s.size()) {
+            out += s[i];
+            continue;
+        }
+        switch (s[++i]) {
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        default: out += s[i];
+        }
+    }
+    return out;
+}
+
+// one "id<TAB>escaped format" line per entry
+void dump_table(const FormatTable &table, const std::string &path)
+{
+    std::ofstream f(path);
+    if (!f)
+        throw std::runtime_error("cannot write " + path);
+    for (const auto &e : table)
+        f << e.first << '\t' << escape(e.second) << '\n';
+}
+
+FormatTable load_table(const std::string &path)
+{
+    std::ifstream f(path);
+    if (!f)
+        throw std::runtime_error("cannot open " + path);
+    FormatTable table;
+    std::string line;
+    while (std::getline(f, line)) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos)
+            continue;
+        table[static_cast<uint16_t>(std::stoul(line.substr(0, tab)))] = unescape(line.substr(tab + 1));
+    }
+    return table;
+}
+
+// ---------------------------------------
+// printf replay
+// ---------------------------------------
+
+float as_float(uint32_t bits)
+{
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+std::string render(const std::string &fmt, const uint32_t *args, size_t nargs)
+{
+    std::string out;
+    size_t used = 0;
+    char buf[64];
+
+    for (size_t i = 0; i < fmt.size(); i++) {
+        if (fmt[i] != '%') {
+            out += fmt[i];
+            continue;
+        }
+        if (i + 1 < fmt.size() && fmt[i + 1] == '%') {
+            out += '%';
+            i++;
+            continue;
+        }
+
+        // copy flags/width/precision, drop length modifiers (every argument is 32 bit)
+        std::string spec = "%";
+        size_t j = i + 1;
+        while (j < fmt.size() && std::strchr("-+ #0123456789.", fmt[j]))
+            spec += fmt[j++];
+        while (j < fmt.size() && std::strchr("hlLzjt", fmt[j]))
+            j++;
+        if (j >= fmt.size())
+            break;
+        char conv = fmt[j];
+        i = j;
+
+        if (used >= nargs) {
+            out += "<missing>";
+            continue;
+        }
+        uint32_t a = args[used++];
+        spec += conv;
+        switch (conv) {
+        case 'd': case 'i':
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<int32_t>(a));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            std::snprintf(buf, sizeof(buf), spec.c_str(), a);
+            break;
+        case 'c':
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<int>(a));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<double>(as_float(a)));
+            break;
+        default:
+            std::snprintf(buf, sizeof(buf), "<%%%c?>", conv);
+            break;
+        }
+        out += buf;
+    }
+    return out;
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: crane_trace (-e firmware.elf | -t table.tsv) [-b baud] [-s] [input]\n"
+                 "       crane_trace -e firmware.elf --dump-table table.tsv\n"
+                 "  input     serial device, pty, capture file or - for stdin (default -)\n"
+                 "  -b baud   serial baud rate (default 115200)\n"
+                 "  -s        print link statistics on exit\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string elf_path, table_path, dump_path, input = "-";
+    unsigned baud = 115200;
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "-e") elf_path = next();
+        else if (a == "-t") table_path = next();
+        else if (a == "-b") baud = static_cast<unsigned>(std::stoul(next()));
+        else if (a == "-s") stats = true;
+        else if (a == "--dump-table") dump_path = next();
+        else if (a == "-h" || a == "--help") { usage(); return 0; }
+        else input = a;
+    }
+
+    try {
+        if (elf_path.empty() == table_path.empty()) {
+            usage();
+            return 2;
+        }
+        FormatTable table = elf_path.empty() ? load_table(table_path) : load_elf(elf_path);
+
+        if (!dump_path.empty()) {
+            dump_table(table, dump_path);
+            std::fprintf(stderr, "%zu format strings written to %s\n", table.size(), dump_path.c_str());
+            return 0;
+        }
+
+        cranelink::Decoder dec(
+            [&](uint8_t type, const uint8_t *p, size_t len) {
+                if (type != cranelink::FRAME_TRACE || len < 6)
+                    return;
+                uint16_t id = cranelink::rd16(p);
+                uint32_t tick = cranelink::rd32(p + 2);
+                uint32_t args[8];
+                size_t nargs = (len - 6) / 4;
+                if (nargs > 8)
+                    nargs = 8;
+                for (size_t k = 0; k < nargs; k++)
+                    args[k] = cranelink::rd32(p + 6 + 4 * k);
+
+                auto it = table.find(id);
+                std::string text = it == table.end() ? "<unknown trace id " + std::to_string(id) + ">"
+                                                     : render(it->second, args, nargs);
+                std::printf("[%6u.%03u] %s\n", tick / 1000, tick % 1000, text.c_str());
+                std::fflush(stdout);
+            },
+            [](const std::string &text) {
+                std::fwrite(text.data(), 1, text.size(), stdout);
+                std::fflush(stdout);
+            });
+
+        int fd = serial::open_input(input, baud);
+        uint8_t buf[4096];
+        for (;;) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            dec.feed(buf, static_cast<size_t>(n));
+        }
+
+        if (stats) {
+            const cranelink::Stats &s = dec.stats();
+            std::fprintf(stderr, "bytes %llu  frames %llu  crc errors %llu  cobs errors %llu  text bytes %llu\n",
+                         static_cast<unsigned long long>(s.bytes), static_cast<unsigned long long>(s.frames),
+                         static_cast<unsigned long long>(s.crc_errors),
+                         static_cast<unsigned long long>(s.cobs_errors),
+                         static_cast<unsigned long long>(s.text_bytes));
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "crane_trace: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
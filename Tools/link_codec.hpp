@@ -0,0 +1,193 @@
+// link_codec.hpp
+//
+// Host side of the firmware's serial link framing (Core/Inc/User/link.h):
+//   0x00 | COBS( type, payload..., crc16 lo, crc16 hi ) | 0x00
+// Text from print_str() is interleaved between frames and is passed through.
+
+#ifndef TOOLS_LINK_CODEC_HPP
+#define TOOLS_LINK_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cranelink {
+
+enum FrameType : uint8_t {
+    FRAME_TRACE = 1,
+    FRAME_TELEMETRY = 2,
+};
+
+// crc16-ccitt-false, same nibble table as link.c
+inline uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF)
+{
+    static const uint16_t nibble[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    while (len--) {
+        uint8_t b = *data++;
+        crc = static_cast<uint16_t>((crc << 4) ^ nibble[(crc >> 12) ^ (b >> 4)]);
+        crc = static_cast<uint16_t>((crc << 4) ^ nibble[(crc >> 12) ^ (b & 0x0F)]);
+    }
+    return crc;
+}
+
+// returns false on a malformed block (a zero inside, or a code running past the end)
+inline bool cobs_decode(const uint8_t *in, size_t len, std::vector<uint8_t> &out)
+{
+    out.clear();
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len)
+            return false;
+        for (uint8_t k = 1; k < code; k++) {
+            if (in[i] == 0)
+                return false;
+            out.push_back(in[i++]);
+        }
+        if (code != 0xFF && i < len)
+            out.push_back(0);
+    }
+    return true;
+}
+
+inline void cobs_encode(const uint8_t *in, size_t len, std::vector<uint8_t> &out)
+{
+    size_t code_idx = out.size();
+    out.push_back(0);
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_idx] = code;
+            code_idx = out.size();
+            out.push_back(0);
+            code = 1;
+        } else {
+            out.push_back(in[i]);
+            if (++code == 0xFF) {
+                out[code_idx] = code;
+                code_idx = out.size();
+                out.push_back(0);
+                code = 1;
+            }
+        }
+    }
+    out[code_idx] = code;
+}
+
+// builds a complete delimited frame, the inverse of link_send_frame()
+inline std::vector<uint8_t> encode_frame(uint8_t type, const uint8_t *payload, size_t len)
+{
+    std::vector<uint8_t> raw;
+    raw.reserve(len + 3);
+    raw.push_back(type);
+    raw.insert(raw.end(), payload, payload + len);
+    uint16_t crc = crc16(raw.data(), raw.size());
+    raw.push_back(static_cast<uint8_t>(crc & 0xFF));
+    raw.push_back(static_cast<uint8_t>(crc >> 8));
+
+    std::vector<uint8_t> out;
+    out.reserve(raw.size() + raw.size() / 254 + 3);
+    out.push_back(0);
+    cobs_encode(raw.data(), raw.size(), out);
+    out.push_back(0);
+    return out;
+}
+
+inline uint16_t rd16(const uint8_t *p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t rd32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+struct Stats {
+    uint64_t bytes = 0;
+    uint64_t frames = 0;
+    uint64_t crc_errors = 0;     // decoded but checksum mismatch
+    uint64_t cobs_errors = 0;    // binary chunk that was not valid cobs
+    uint64_t text_bytes = 0;
+};
+
+// Splits a byte stream on 0x00 and hands out frames and text. Resynchronises by itself:
+// whatever garbage comes before the next delimiter is reported as an error or as text.
+class Decoder {
+public:
+    using FrameFn = std::function<void(uint8_t type, const uint8_t *payload, size_t len)>;
+    using TextFn = std::function<void(const std::string &text)>;
+
+    Decoder(FrameFn on_frame, TextFn on_text) : on_frame_(std::move(on_frame)), on_text_(std::move(on_text)) {}
+
+    void feed(const uint8_t *data, size_t len)
+    {
+        stats_.bytes += len;
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] == 0) {
+                flush();
+            } else {
+                chunk_.push_back(data[i]);
+                // a frame is never this long, treat a runaway chunk as text/garbage
+                if (chunk_.size() > kMaxChunk)
+                    flush();
+            }
+        }
+        // text lines are not followed by a delimiter until the next frame, so hand out
+        // a finished line right away instead of holding it back
+        if (!chunk_.empty() && chunk_.back() == '\n' && is_text(chunk_))
+            flush();
+    }
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    static constexpr size_t kMaxChunk = 4096;
+
+    static bool is_text(const std::vector<uint8_t> &c)
+    {
+        for (uint8_t b : c) {
+            if (b < 0x20 && b != '\r' && b != '\n' && b != '\t')
+                return false;
+        }
+        return true;
+    }
+
+    void flush()
+    {
+        if (chunk_.empty())
+            return;
+        bool decoded = cobs_decode(chunk_.data(), chunk_.size(), raw_) && raw_.size() >= 3;
+        if (decoded) {
+            size_t n = raw_.size() - 2;
+            if (crc16(raw_.data(), n) == rd16(&raw_[n])) {
+                stats_.frames++;
+                on_frame_(raw_[0], raw_.data() + 1, n - 1);
+                chunk_.clear();
+                return;
+            }
+        }
+        if (is_text(chunk_)) {
+            stats_.text_bytes += chunk_.size();
+            if (on_text_)
+                on_text_(std::string(chunk_.begin(), chunk_.end()));
+        } else if (decoded) {
+            stats_.crc_errors++;
+        } else {
+            stats_.cobs_errors++;
+        }
+        chunk_.clear();
+    }
+
+    FrameFn on_frame_;
+    TextFn on_text_;
+    std::vector<uint8_t> chunk_;
+    std::vector<uint8_t> raw_;
+    Stats stats_;
+};
+
+} // namespace cranelink
+
+#endif // TOOLS_LINK_CODEC_HPP
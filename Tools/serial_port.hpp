@@ -0,0 +1,66 @@
+// serial_port.hpp
+//
+// Opens the byte source for the host tools: a serial device or pty (configured raw at the
+// requested baud rate), a capture file, or "-" for stdin.
+
+#ifndef TOOLS_SERIAL_PORT_HPP
+#define TOOLS_SERIAL_PORT_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace serial {
+
+inline speed_t baud_constant(unsigned baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: throw std::runtime_error("unsupported baud rate " + std::to_string(baud));
+    }
+}
+
+inline void make_raw(int fd, unsigned baud)
+{
+    termios tio {};
+    if (tcgetattr(fd, &tio) != 0)
+        throw std::runtime_error(std::string("tcgetattr: ") + std::strerror(errno));
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    speed_t sp = baud_constant(baud);
+    cfsetispeed(&tio, sp);
+    cfsetospeed(&tio, sp);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+        throw std::runtime_error(std::string("tcsetattr: ") + std::strerror(errno));
+}
+
+// returns a readable fd, the caller closes it
+inline int open_input(const std::string &path, unsigned baud)
+{
+    if (path == "-")
+        return STDIN_FILENO;
+    int fd = ::open(path.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    if (isatty(fd))
+        make_raw(fd, baud);
+    return fd;
+}
+
+} // namespace serial
+
+#endif // TOOLS_SERIAL_PORT_HPP
@@ -0,0 +1,157 @@
+// telemetry_frame.hpp
+//
+// Host mirror of TelemetryFrame (Core/Inc/User/telemetry.h). Keep the two in step.
+
+#ifndef TOOLS_TELEMETRY_FRAME_HPP
+#define TOOLS_TELEMETRY_FRAME_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "link_codec.hpp"
+
+namespace telemetry {
+
+struct Frame {
+    uint16_t seq;
+    uint32_t tick;
+    int32_t height_um;
+    uint16_t height_norm; // 0..kNormOne
+    uint8_t mode;
+    uint8_t auto_step;
+    uint16_t ccr1;
+    uint16_t ccr2;
+    uint8_t control_queue;
+    uint8_t servo_queue;
+    int32_t height_filt_um;
+    int32_t velocity_um_s;
+    uint8_t sensor_status; // 0 ok, 1 no echo, 2 out of range
+    uint16_t echo_timeouts;
+    uint16_t out_of_range;
+    uint16_t outliers;
+    uint8_t sample_hz;
+    uint16_t latency_us;
+};
+
+constexpr size_t kWireSize = 38;
+constexpr double kNormOne = 10000.0; // SENSOR_NORM_ONE
+constexpr double kUmPerCm = 10000.0;
+constexpr int32_t kHeightInvalid = -1; // SENSOR_HEIGHT_INVALID
+
+// um to cm, NaN for the no-echo sentinel so it never reads as a real height
+inline double height_cm(int32_t um)
+{
+    return um == kHeightInvalid ? std::nan("") : um / kUmPerCm;
+}
+
+inline int32_t i32(const uint8_t *p)
+{
+    return static_cast<int32_t>(cranelink::rd32(p));
+}
+
+inline bool parse(const uint8_t *p, size_t len, Frame &f)
+{
+    if (len != kWireSize)
+        return false;
+    f.seq = cranelink::rd16(p + 0);
+    f.tick = cranelink::rd32(p + 2);
+    f.height_um = i32(p + 6);
+    f.height_norm = cranelink::rd16(p + 10);
+    f.mode = p[12];
+    f.auto_step = p[13];
+    f.ccr1 = cranelink::rd16(p + 14);
+    f.ccr2 = cranelink::rd16(p + 16);
+    f.control_queue = p[18];
+    f.servo_queue = p[19];
+    f.height_filt_um = i32(p + 20);
+    f.velocity_um_s = i32(p + 24);
+    f.sensor_status = p[28];
+    f.echo_timeouts = cranelink::rd16(p + 29);
+    f.out_of_range = cranelink::rd16(p + 31);
+    f.outliers = cranelink::rd16(p + 33);
+    f.sample_hz = p[35];
+    f.latency_us = cranelink::rd16(p + 36);
+    return true;
+}
+
+inline void put16(std::vector<uint8_t> &v, uint16_t x)
+{
+    v.push_back(static_cast<uint8_t>(x));
+    v.push_back(static_cast<uint8_t>(x >> 8));
+}
+
+inline void put32(std::vector<uint8_t> &v, uint32_t x)
+{
+    for (int i = 0; i < 4; i++)
+        v.push_back(static_cast<uint8_t>(x >> (8 * i)));
+}
+
+
+inline std::vector<uint8_t> serialize(const Frame &f)
+{
+    std::vector<uint8_t> v;
+    v.reserve(kWireSize);
+    put16(v, f.seq);
+    put32(v, f.tick);
+    put32(v, static_cast<uint32_t>(f.height_um));
+    put16(v, f.height_norm);
+    v.push_back(f.mode);
+    v.push_back(f.auto_step);
+    put16(v, f.ccr1);
+    put16(v, f.ccr2);
+    v.push_back(f.control_queue);
+    v.push_back(f.servo_queue);
+    put32(v, static_cast<uint32_t>(f.height_filt_um));
+    put32(v, static_cast<uint32_t>(f.velocity_um_s));
+    v.push_back(f.sensor_status);
+    put16(v, f.echo_timeouts);
+    put16(v, f.out_of_range);
+    put16(v, f.outliers);
+    v.push_back(f.sample_hz);
+    put16(v, f.latency_us);
+    return v;
+}
+
+// column layout used by the recorder's csv and columnar writers.
+// lengths go out in cm, the unit these columns had before the firmware switched to um, so
+// scripts written against older csv files keep working. the wire frame itself has no version
+// byte and parse() only takes the current 38 byte layout, so older raw captures do not decode.
+// heights are NaN while the sensor has no echo: an empty csv field, a NaN float in columnar
+enum class ColType { U8, U16, U32, F32 };
+
+struct Column {
+    const char *name;
+    ColType type;
+    double (*get)(const Frame &);
+};
+
+inline const std::vector<Column> &columns()
+{
+    static const std::vector<Column> cols = {
+        {"seq", ColType::U16, [](const Frame &f) { return double(f.seq); }},
+        {"tick_ms", ColType::U32, [](const Frame &f) { return double(f.tick); }},
+        {"height_cm", ColType::F32, [](const Frame &f) { return height_cm(f.height_um); }},
+        {"height_norm", ColType::F32, [](const Frame &f) { return f.height_norm / kNormOne; }},
+        {"mode", ColType::U8, [](const Frame &f) { return double(f.mode); }},
+        {"auto_step", ColType::U8, [](const Frame &f) { return double(f.auto_step); }},
+        {"ccr1", ColType::U16, [](const Frame &f) { return double(f.ccr1); }},
+        {"ccr2", ColType::U16, [](const Frame &f) { return double(f.ccr2); }},
+        {"control_queue", ColType::U8, [](const Frame &f) { return double(f.control_queue); }},
+        {"servo_queue", ColType::U8, [](const Frame &f) { return double(f.servo_queue); }},
+        {"height_filt_cm", ColType::F32, [](const Frame &f) { return height_cm(f.height_filt_um); }},
+        {"velocity_cm_s", ColType::F32, [](const Frame &f) { return f.velocity_um_s / kUmPerCm; }},
+        {"sensor_status", ColType::U8, [](const Frame &f) { return double(f.sensor_status); }},
+        {"echo_timeouts", ColType::U16, [](const Frame &f) { return double(f.echo_timeouts); }},
+        {"out_of_range", ColType::U16, [](const Frame &f) { return double(f.out_of_range); }},
+        {"outliers", ColType::U16, [](const Frame &f) { return double(f.outliers); }},
+        {"sample_hz", ColType::U8, [](const Frame &f) { return double(f.sample_hz); }},
+        {"latency_us", ColType::U16, [](const Frame &f) { return double(f.latency_us); }},
+    };
+    return cols;
+}
+
+} // namespace telemetry
+
+#endif // TOOLS_TELEMETRY_FRAME_HPP
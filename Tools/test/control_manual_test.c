@@ -0,0 +1,177 @@
+/*
+ * control_manual_test.c
+ *
+ * host test for ControlTask's manual mode input state across mode changes. ControlTask.c is
+ * built into this file so its statics can be driven directly, the hal, sensor and input layers
+ * are stubbed below and record what the control logic asked them for
+ */
+
+#include "../../Core/Src/User/ControlTask.c"
+
+#include <stdio.h>
+
+// ---------------------------------------
+// stubs
+// ---------------------------------------
+
+DWT_Type test_dwt;
+uint32_t SystemCoreClock = 84000000;
+uint8_t logLevels[LOG_MOD_COUNT];
+uint16_t servo_pwm_stop = 1500;
+uint16_t servo_pwm_vert_forward = 1570;
+uint16_t servo_pwm_vert_backward = 1440;
+
+static uint16_t snapshot;				// what InputTask_GetSnapshot reports
+static int vertMoves[3];				// DIRSTOP, up, down calls
+static int platMoves[3];				// DIRSTOP, right, left calls
+
+uint16_t InputTask_GetSnapshot(void) { return snapshot; }
+
+void Crane_MoveVerticalUp(void) { vertMoves[DIRUP]++; }
+void Crane_MoveVerticalDown(void) { vertMoves[DIRDOWN]++; }
+void Crane_StopVertical(void) { vertMoves[DIRSTOP]++; }
+void Crane_SetVerticalPulse(uint16_t pulse) { (void)pulse; }
+void Crane_MovePlatformRight(void) { platMoves[DIRUP]++; }
+void Crane_MovePlatformLeft(void) { platMoves[DIRDOWN]++; }
+void Crane_StopPlatform(void) { platMoves[DIRSTOP]++; }
+uint8_t Crane_LimitLatched(axis_t axis, dir_t dir) { (void)axis; (void)dir; return 0; }
+int32_t Crane_VerticalSpeedUmS(uint16_t pulse) { (void)pulse; return 0; }
+uint16_t Crane_VerticalPulseForSpeed(int32_t umPerS) { (void)umPerS; return 1500; }
+uint8_t Crane_SetSpeedTable(const speed_point_t *points, uint8_t count) { (void)points; (void)count; return 1; }
+
+void SensorTask_NotifyOnSample(TaskHandle_t task, uint32_t bits) { (void)task; (void)bits; }
+uint32_t SensorTask_GetLatest(CraneSensorData *out) { memset(out, 0, sizeof(*out)); return 0; }
+uint8_t SensorTask_ReadIfNew(CraneSensorData *out, uint32_t *seq) { (void)out; (void)seq; return 0; }
+int32_t SensorTask_PredictHeightUm(void) { return SENSOR_HEIGHT_INVALID; }
+
+void print_str(char *str) { (void)str; }
+void trace_emit(uint16_t fmtId, const uint32_t *args, uint8_t nargs) { (void)fmtId; (void)args; (void)nargs; }
+void log_limited(LogLimiter *lim, const char *fmt, uint8_t burst, uint32_t periodMs, const uint32_t *args, uint8_t nargs)
+{
+	(void)lim; (void)fmt; (void)burst; (void)periodMs; (void)args; (void)nargs;
+}
+
+// no scheduler: ControlTask's handle stays NULL, so every mode change applies on the spot
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+	(void)fn; (void)name; (void)stack; (void)param; (void)prio;
+	*handle = NULL;
+	return pdPASS;
+}
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return NULL; }
+TickType_t xTaskGetTickCount(void) { return 0; }
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t bits, eNotifyAction action) { (void)task; (void)bits; (void)action; return pdPASS; }
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t bits, eNotifyAction action, BaseType_t *woken)
+{
+	(void)task; (void)bits; (void)action; (void)woken;
+	return pdPASS;
+}
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *bits, TickType_t wait)
+{
+	(void)clearOnEntry; (void)clearOnExit; (void)bits; (void)wait;
+	return pdFALSE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) { (void)length; (void)itemSize; return NULL; }
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) { (void)q; (void)item; (void)wait; return pdFAIL; }
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) { (void)q; (void)item; (void)woken; return pdFAIL; }
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) { (void)q; (void)item; (void)wait; return pdFAIL; }
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { (void)q; return 0; }
+
+// ---------------------------------------
+// tests
+// ---------------------------------------
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+// one manual pass, what ControlTask's loop runs after draining the queue
+static void manualPass(void)
+{
+	updateVerticalMotion();
+	updatePlatformMotion();
+}
+
+static void reset(uint16_t levels)
+{
+	snapshot = levels;
+	memset(vertMoves, 0, sizeof(vertMoves));
+	memset(platMoves, 0, sizeof(platMoves));
+	applyMode(MODE_MANUAL);
+}
+
+// switch thrown and button held before auto, still held when auto hands back to manual
+static void test_switch_held_across_auto(void)
+{
+	printf("switch held across auto -> manual\n");
+	reset((1U << IN_SW_VERT_UP) | (1U << IN_BUT_VERT));
+	manualPass();
+	CHECK(vertMoves[DIRUP] == 1);
+
+	applyMode(MODE_AUTO);
+	applyMode(MODE_MANUAL);		// no new events: nothing changed at the inputs
+	vertMoves[DIRUP] = 0;
+	manualPass();
+	CHECK(vertMoves[DIRUP] == 1);
+	CHECK(vertCurrentMotion == DIR_UP);
+}
+
+// thrown while auto ran (its event was ignored there)
+static void test_switch_thrown_during_auto(void)
+{
+	printf("switch thrown during auto\n");
+	reset(0);
+	applyMode(MODE_AUTO);
+	snapshot = (1U << IN_SW_PLAT_L) | (1U << IN_BUT_PLAT) | (1U << IN_SW_VERT_DN);
+	applyMode(MODE_MANUAL);
+	manualPass();
+	CHECK(platMoves[DIRDOWN] == 1);
+	CHECK(vertSwitchDir == DIR_DOWN);
+	CHECK(vertMoves[DIRUP] == 0 && vertMoves[DIRDOWN] == 0);	// vertical button not held
+}
+
+// released during auto, manual mustn't move on stale state
+static void test_released_during_auto(void)
+{
+	printf("released during auto\n");
+	reset((1U << IN_SW_VERT_UP) | (1U << IN_BUT_VERT));
+	manualPass();
+	applyMode(MODE_AUTO);
+	snapshot = 0;
+	applyMode(MODE_MANUAL);
+	vertMoves[DIRUP] = 0;
+	manualPass();
+	CHECK(vertMoves[DIRUP] == 0);
+	CHECK(!vertButtonHeld && vertSwitchDir == DIR_NONE);
+}
+
+// blocked (a limit in manual) doesn't act on inputs, nothing to seed
+static void test_blocked_not_seeded(void)
+{
+	printf("blocked keeps inputs clear\n");
+	reset((1U << IN_SW_VERT_UP) | (1U << IN_BUT_VERT));
+	applyMode(MODE_BLOCKED);
+	CHECK(!vertButtonHeld && vertSwitchDir == DIR_NONE);
+}
+
+int main(void)
+{
+	memset(logLevels, LOG_LVL_OFF, sizeof(logLevels));
+	ControlTask_Init();
+
+	test_switch_held_across_auto();
+	test_switch_thrown_during_auto();
+	test_released_during_auto();
+	test_blocked_not_seeded();
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
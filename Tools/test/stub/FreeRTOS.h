@@ -0,0 +1,31 @@
+/*
+ * FreeRTOS.h
+ *
+ * host stand-in: the types and macros the User/ sources use. the calls behind them are
+ * implemented by the test (single threaded, no scheduler)
+ */
+
+#ifndef TEST_STUB_FREERTOS_H_
+#define TEST_STUB_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE					((BaseType_t)0)
+#define pdTRUE					((BaseType_t)1)
+#define pdPASS					pdTRUE
+#define pdFAIL					pdFALSE
+#define portTICK_PERIOD_MS		((TickType_t)1)
+#define pdMS_TO_TICKS(ms)		((TickType_t)(ms))
+#define portMAX_DELAY			((TickType_t)0xFFFFFFFFUL)
+#define tskIDLE_PRIORITY		((UBaseType_t)0)
+#define configMINIMAL_STACK_SIZE	128
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define portYIELD_FROM_ISR(x)	((void)(x))
+
+#endif /* TEST_STUB_FREERTOS_H_ */
@@ -0,0 +1,22 @@
+/*
+ * main.h
+ *
+ * host stand-in for the cube generated main.h, just enough for the User/ headers to compile
+ * with gcc on linux (Tools/test)
+ */
+
+#ifndef TEST_STUB_MAIN_H_
+#define TEST_STUB_MAIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct { int instance; } TIM_HandleTypeDef;
+
+typedef struct { volatile uint32_t CYCCNT; } DWT_Type;
+extern DWT_Type test_dwt;
+#define DWT			(&test_dwt)
+
+extern uint32_t SystemCoreClock;
+
+#endif /* TEST_STUB_MAIN_H_ */
@@ -0,0 +1,20 @@
+/*
+ * queue.h
+ *
+ * host stand-in, see FreeRTOS.h
+ */
+
+#ifndef TEST_STUB_QUEUE_H_
+#define TEST_STUB_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+typedef struct TestQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif /* TEST_STUB_QUEUE_H_ */
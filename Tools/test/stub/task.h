@@ -0,0 +1,24 @@
+/*
+ * task.h
+ *
+ * host stand-in, see FreeRTOS.h
+ */
+
+#ifndef TEST_STUB_TASK_H_
+#define TEST_STUB_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef enum { eNoAction = 0, eSetBits } eNotifyAction;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                       UBaseType_t prio, TaskHandle_t *handle);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t bits, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t bits, eNotifyAction action, BaseType_t *woken);
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *bits, TickType_t wait);
+
+#endif /* TEST_STUB_TASK_H_ */